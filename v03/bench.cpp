@@ -0,0 +1,347 @@
+/**
+ * Bench.cpp
+ *   Microbenchmarks of the runtime primitives, i.e. what creating, releasing
+ *   and waiting for tasks costs, on small graphs dispatched straight through
+ *   the runtime symbols
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <chrono>
+
+/* ************************
+ * Microbenchmark state
+ * ************************ */
+/**
+ * Parameters of a benchmark task, held on its private data
+ */
+typedef struct bench_param {
+    std::atomic<bool>* gate;    // task waits until it opens (NULL: no wait)
+    uint64_t           beg;     // when the task started (ns)
+    uint64_t           end;     // when the task finished (ns)
+} bparam_t;
+
+/**
+ * Outcome of a benchmark, one sample per measured event (ns)
+ */
+typedef struct bench_result {
+    const char*           name;
+    uint32_t              k;        // no. of dependencies or tasks (0: none)
+    std::vector<uint64_t> samples;
+} bres_t;
+
+/**
+ * Suite of benchmarks being measured, handed to its microtask
+ */
+typedef struct bench_suite {
+    uint32_t            reps;   // repetitions of each benchmark
+    std::vector<bres_t> res;    // outcome of each benchmark
+} bsuite_t;
+
+/* Current time, in nanoseconds */
+static uint64_t stamp() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Time from a to b, if b came later */
+static uint64_t gap(const uint64_t a, const uint64_t b) {
+    return b > a ? b - a : 0;
+}
+
+/* Create a task running f on p, with nd dependencies */
+static void spawn(kmp_routine_entry f, bparam_t* p, kmp_depend_info* deps,
+                  const uint32_t nd) {
+    kmp_task* task = (kmp_task*)omp_task_alloc(NULL, 0, 0,
+                                               sizeof(kmp_task) + sizeof(p),
+                                               0, f);
+
+    // Parameters go on the private data, so that no dependency is needed
+    *(bparam_t**)(task + 1) = p;
+
+    omp_task_with_deps(NULL, 0, task, nd, deps, 0, NULL);
+}
+
+/* Describe a dependency on addr */
+static kmp_depend_info dep_on(const void* addr, const uint8_t type) {
+    kmp_depend_info d;
+
+    d.base_addr = (kmp_intptr)addr;
+    d.len       = 1;
+    d.flags.in  = type != Type::OUT;
+    d.flags.out = type != Type::IN;
+
+    return d;
+}
+
+/* ************************
+ * Microbenchmarks
+ * ************************ */
+bool TaskLab::bench(const uint8_t rt, const uint32_t reps,
+                    const char* filename) {
+    if (reps == 0) {
+        fprintf(stderr, "[ERROR] Microbenchmarks need at least one repetition.\n");
+
+        return false;
+    }
+
+    FILE* out = NULL;
+
+    if (filename != NULL && (out = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't write results.\n");
+
+        return false;
+    }
+
+    /* Initialize runtime functions based on the runtime */
+    if (!init_run(rt)) {
+        /* Uh oh! Something went wrong! */
+        if (out != NULL) {
+            fclose(out);
+        }
+
+        return false;
+    }
+
+    bsuite_t             b   = { reps, std::vector<bres_t>() };
+    std::vector<bres_t>& res = b.res;
+
+    if (rt == RT::MTSP) {
+        // Start execution of a parallel region
+        fork_call(NULL, 1, (kmpc_micro) bench_microtask, &b);
+    }
+
+    printf("--- Runtime microbenchmarks (ns)\n");
+    printf("\t\t%-16s %4s %10s %10s %10s %10s %10s\n", "primitive", "k",
+           "samples", "mean", "p50", "p99", "max");
+
+    if (out != NULL) {
+        fprintf(out, "primitive,k,samples,mean_ns,p50_ns,p99_ns,max_ns\n");
+    }
+
+    for (size_t i = 0; i < res.size(); i++) {
+        std::vector<uint64_t>& s = res[i].samples;
+        double                 sum = 0;
+
+        if (s.empty()) {
+            continue;
+        }
+
+        std::sort(s.begin(), s.end());
+
+        for (size_t j = 0; j < s.size(); j++) {
+            sum += s[j];
+        }
+
+        char k[16] = "-";
+
+        if (res[i].k > 0) {
+            sprintf(k, "%u", res[i].k);
+        }
+
+        unsigned long long p50 = s[s.size() / 2];
+        unsigned long long p99 = s[std::min(s.size() - 1, s.size() * 99 / 100)];
+
+        printf("\t\t%-16s %4s %10zu %10.1f %10llu %10llu %10llu\n",
+               res[i].name, k, s.size(), sum / s.size(), p50, p99,
+               (unsigned long long)s.back());
+
+        if (out != NULL) {
+            fprintf(out, "%s,%u,%zu,%.1f,%llu,%llu,%llu\n", res[i].name,
+                    res[i].k, s.size(), sum / s.size(), p50, p99,
+                    (unsigned long long)s.back());
+        }
+    }
+
+    if (out != NULL) {
+        fclose(out);
+    }
+
+    return true;
+}
+
+void TaskLab::bench_microtask(int gid, int tid, void* param) {
+    kmp_routine_entry      f = (kmp_routine_entry)btask_f;
+    bsuite_t*              b = (bsuite_t*) param;
+    uint32_t               n = b->reps;
+    std::atomic<bool>      gate;
+    std::vector<bparam_t>  p(BENCH_BATCH + 1);
+    std::vector<char>      vars(BENCH_BATCH * BENCH_MAX_DEPS);
+    kmp_depend_info        d[BENCH_MAX_DEPS];
+    bres_t                 r;
+
+    std::cout << "Start benchmarking the runtime!\n";
+
+    /* -- Empty task: creation only, drained every batch */
+    r = { "spawn", 0, std::vector<uint64_t>() };
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t t0 = stamp();
+
+        spawn(f, NULL, NULL, 0);
+
+        r.samples.push_back(stamp() - t0);
+
+        if ((i + 1) % BENCH_BATCH == 0) {
+            omp_taskwait(NULL, 0);
+        }
+    }
+
+    omp_taskwait(NULL, 0);
+    b->res.push_back(r);
+
+    /* -- Task with k dependencies, all on new addresses */
+    for (uint32_t k = 1; k <= BENCH_MAX_DEPS; k++) {
+        r = { "spawn deps", k, std::vector<uint64_t>() };
+
+        for (uint32_t i = 0; i < n; i++) {
+            char* v = &vars[(i % BENCH_BATCH) * BENCH_MAX_DEPS];
+
+            for (uint32_t j = 0; j < k; j++) {
+                d[j] = dep_on(v + j, Type::INOUT);
+            }
+
+            uint64_t t0 = stamp();
+
+            spawn(f, NULL, d, k);
+
+            r.samples.push_back(stamp() - t0);
+
+            if ((i + 1) % BENCH_BATCH == 0) {
+                omp_taskwait(NULL, 0);
+            }
+        }
+
+        omp_taskwait(NULL, 0);
+        b->res.push_back(r);
+    }
+
+    /* -- Chain: from a task finishing until its successor starts. Each
+     * segment is created before its first task may start */
+    r = { "chain release", 0, std::vector<uint64_t>() };
+
+    for (uint32_t i = 0; i < n; i += BENCH_BATCH) {
+        uint32_t m = std::min(n - i, (uint32_t)BENCH_BATCH);
+
+        gate = false;
+        d[0] = dep_on(&vars[0], Type::INOUT);
+
+        for (uint32_t j = 0; j < m; j++) {
+            p[j] = { j == 0 ? &gate : NULL, 0, 0 };
+
+            spawn(f, &p[j], d, 1);
+        }
+
+        gate = true;
+        omp_taskwait(NULL, 0);
+
+        for (uint32_t j = 1; j < m; j++) {
+            r.samples.push_back(gap(p[j - 1].end, p[j].beg));
+        }
+    }
+
+    b->res.push_back(r);
+
+    /* -- Fan-out: from a task finishing until each of its N children starts */
+    for (uint32_t w = 4; w <= BENCH_BATCH; w <<= 2) {
+        r = { "fan-out wake-up", w, std::vector<uint64_t>() };
+
+        for (uint32_t i = 0; i < std::max(n / w, 1u); i++) {
+            gate = false;
+            p[0] = { &gate, 0, 0 };
+            d[0] = dep_on(&vars[0], Type::OUT);
+
+            spawn(f, &p[0], d, 1);
+
+            d[0] = dep_on(&vars[0], Type::IN);
+
+            for (uint32_t j = 1; j <= w; j++) {
+                p[j] = { NULL, 0, 0 };
+
+                spawn(f, &p[j], d, 1);
+            }
+
+            gate = true;
+            omp_taskwait(NULL, 0);
+
+            for (uint32_t j = 1; j <= w; j++) {
+                r.samples.push_back(gap(p[0].end, p[j].beg));
+            }
+        }
+
+        b->res.push_back(r);
+    }
+
+    /* -- Fan-in: from the last of N tasks finishing until their join starts */
+    for (uint32_t w = 4; w <= BENCH_MAX_DEPS; w <<= 2) {
+        r = { "fan-in join", w, std::vector<uint64_t>() };
+
+        for (uint32_t i = 0; i < std::max(n / w, 1u); i++) {
+            gate = false;
+
+            for (uint32_t j = 0; j < w; j++) {
+                p[j] = { &gate, 0, 0 };
+                d[0] = dep_on(&vars[j], Type::OUT);
+
+                spawn(f, &p[j], d, 1);
+            }
+
+            for (uint32_t j = 0; j < w; j++) {
+                d[j] = dep_on(&vars[j], Type::IN);
+            }
+
+            p[w] = { NULL, 0, 0 };
+
+            spawn(f, &p[w], d, w);
+
+            gate = true;
+            omp_taskwait(NULL, 0);
+
+            uint64_t last = 0;
+
+            for (uint32_t j = 0; j < w; j++) {
+                last = std::max(last, p[j].end);
+            }
+
+            r.samples.push_back(gap(last, p[w].beg));
+        }
+
+        b->res.push_back(r);
+    }
+
+    /* -- Taskwait: create an empty task and wait for it */
+    r = { "taskwait", 0, std::vector<uint64_t>() };
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t t0 = stamp();
+
+        spawn(f, NULL, NULL, 0);
+        omp_taskwait(NULL, 0);
+
+        r.samples.push_back(stamp() - t0);
+    }
+
+    b->res.push_back(r);
+
+    std::cout << "\tDone benchmarking!\n";
+}
+
+void TaskLab::btask_f(kmp_int32 gtid, void* param) {
+    kmp_task* t = (kmp_task*) param;
+    bparam_t* p = *(bparam_t**)(t + 1);
+
+    if (p == NULL) {
+        return;
+    }
+
+    if (p->gate) {
+        while (!p->gate->load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    p->beg = stamp();
+    p->end = stamp();
+}
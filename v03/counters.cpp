@@ -0,0 +1,355 @@
+/**
+ * Counters.cpp
+ *   Hardware performance counters of runs (perf_event_open): every thread
+ *   counts its own events on a group of counters, read around each task, so
+ *   that the time spent by the runtime can be told apart from the tasks'
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <cerrno>
+#include <mutex>
+#include <chrono>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* ************************
+ * Counted events
+ * ************************ */
+typedef struct counter_event {
+    uint32_t    type;
+    uint64_t    config;
+    const char* name;
+} cevt_t;
+
+/* Hardware events go first, so that the group is led by one of them */
+static const cevt_t events[NCTR] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,       "cycles"        },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,     "instructions"  },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,     "cache-misses"  },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,    "branch-misses" },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "ctx-switches"  },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS,   "migrations"    },
+};
+
+/* ************************
+ * Counter groups
+ * ************************ */
+/**
+ * Counters of a thread, as a single group so that they are read at once and
+ * scheduled together on the PMU
+ */
+typedef struct counter_group {
+    int      fd[NCTR];      // counter of each event (-1 if not counted)
+    int      pos[NCTR];     // position of each event on a group read
+    int      lead;          // group leader
+    uint32_t n;             // no. of events counted
+    int32_t  gtid;          // runtime id of the thread (NONE if it ran no task)
+    pid_t    tid;           // thread counted
+    uint64_t base[NCTR];    // counts when the group was opened
+    bool     muxed;         // whether the group was ever multiplexed
+} cgrp_t;
+
+static std::mutex           c_lock;         // guards c_grp
+static std::atomic<bool>    c_busy(false);  // whether a run is counting
+static std::vector<cgrp_t*> c_grp;          // groups of the current run
+static std::atomic<uint64_t> c_gen(0);      // current run, so that threads
+                                            // look up their group on a new one
+static pid_t                c_disp;         // thread dispatching the run
+static std::atomic<uint32_t> c_join(0);     // threads that joined the region
+static uint32_t             c_team;         // threads expected to join it
+
+static thread_local cgrp_t*  mine     = NULL;
+static thread_local uint64_t mine_gen = (uint64_t)-1;
+
+static pid_t gettid_() {
+    return syscall(SYS_gettid);
+}
+
+static int perf_open(perf_event_attr* a, const pid_t tid, const int group) {
+    return syscall(SYS_perf_event_open, a, tid, -1, group, PERF_FLAG_FD_CLOEXEC);
+}
+
+/* Open the counters of a thread, possibly another one, user space only if
+ * the kernel cannot be counted (perf_event_paranoid) */
+static cgrp_t* open_group(const pid_t tid) {
+    cgrp_t* g = new cgrp_t();
+
+    g->lead  = -1;
+    g->n     = 0;
+    g->gtid  = NONE;
+    g->tid   = tid;
+    g->muxed = false;
+
+    for (int i = 0; i < NCTR; i++) {
+        perf_event_attr a;
+
+        memset(&a, 0, sizeof(a));
+
+        a.size        = sizeof(a);
+        a.type        = events[i].type;
+        a.config      = events[i].config;
+        a.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                        PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        g->fd[i]  = perf_open(&a, tid, g->lead);
+
+        if (g->fd[i] < 0 && errno == EACCES) {
+            a.exclude_kernel = 1;
+            a.exclude_hv     = 1;
+
+            g->fd[i] = perf_open(&a, tid, g->lead);
+        }
+
+        g->pos[i] = g->fd[i] < 0 ? NONE : g->n++;
+
+        if (g->lead < 0) {
+            g->lead = g->fd[i];
+        }
+    }
+
+    return g;
+}
+
+/* Current counts of a group, possibly of another thread */
+static void read_group(cgrp_t* g, uint64_t* v) {
+    uint64_t buf[3 + NCTR];     // nr, time enabled, time running, values
+
+    memset(v, 0, NCTR * sizeof(uint64_t));
+
+    if (g->n == 0 || read(g->lead, buf, sizeof(buf)) <= 0) {
+        return;
+    }
+
+    g->muxed = g->muxed || buf[2] < buf[1];
+
+    for (int i = 0; i < NCTR; i++) {
+        if (g->pos[i] != NONE) {
+            v[i] = buf[3 + g->pos[i]];
+        }
+    }
+}
+
+static void close_group(cgrp_t* g) {
+    for (int i = 0; i < NCTR; i++) {
+        if (g->fd[i] >= 0) {
+            close(g->fd[i]);
+        }
+    }
+
+    delete g;
+}
+
+/* Group of a thread on the current run, opened if it has none yet (c_lock
+ * held) */
+static cgrp_t* group_of(const pid_t tid) {
+    for (size_t i = 0; i < c_grp.size(); i++) {
+        if (c_grp[i]->tid == tid) {
+            return c_grp[i];
+        }
+    }
+
+    cgrp_t* g = open_group(tid);
+
+    read_group(g, g->base);
+
+    c_grp.push_back(g);
+
+    return g;
+}
+
+/* Group of the current thread on the current run */
+static cgrp_t* group() {
+    uint64_t gen = c_gen.load(std::memory_order_acquire);
+
+    if (mine_gen != gen) {
+        std::lock_guard<std::mutex> l(c_lock);
+
+        mine     = group_of(gettid_());
+        mine_gen = gen;
+    }
+
+    return mine;
+}
+
+/* ************************
+ * Run counters
+ * ************************ */
+bool TaskLab::ctr_start() {
+    // Threads are shared by concurrent runs, so only one of them counts
+    if (c_busy.exchange(true)) {
+        fprintf(stderr, "[ERROR] Hardware events are being counted by another \
+run.\n");
+
+        return false;
+    }
+
+    ++c_gen;
+
+    c_disp = gettid_();
+
+    // The dispatching thread counts from now on, the others from the region
+    if (group()->n == 0) {
+        fprintf(stderr, "[ERROR] Couldn't open any hardware counter \
+(perf_event_open: %s).\n", strerror(errno));
+
+        std::lock_guard<std::mutex> l(c_lock);
+
+        close_group(c_grp.back());
+        c_grp.clear();
+
+        c_busy = false;
+
+        return false;
+    }
+
+    return true;
+}
+
+/* Task joining a thread to the region: open its counters, and hold it until
+ * the rest of the team took one too (or CTR_JOIN us went by), so that every
+ * thread takes a single one */
+static void join_f(kmp_int32 gtid, void* param) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    group();
+
+    ++c_join;
+
+    while (c_join < c_team && std::chrono::steady_clock::now() - t0 <
+                              std::chrono::microseconds(CTR_JOIN)) {
+        std::this_thread::yield();
+    }
+}
+
+void TaskLab::ctr_team(kmp_int32 gtid) {
+    // Workers run nothing of ours until a task, so hand each of them one
+    c_team = team_size() - 1;
+    c_join = 0;
+
+    for (uint32_t k = 0; k < c_team; k++) {
+        kmp_task* task = (kmp_task*)omp_task_alloc(NULL, gtid, 0, sizeof(kmp_task),
+                                                   0, (kmp_routine_entry)join_f);
+
+        omp_task_with_deps(NULL, gtid, task, 0, NULL, 0, NULL);
+    }
+}
+
+void TaskLab::ctr_read(kmp_int32 gtid, uint64_t* v) {
+    cgrp_t* g = group();
+
+    g->gtid = gtid;
+
+    read_group(g, v);
+}
+
+/* Print a row of counts, with IPC and misses per thousand instructions */
+static void crow(const char* label, const uint64_t* v, const bool* on) {
+    printf("\t\t%-12s", label);
+
+    for (int i = 0; i < NCTR; i++) {
+        if (on[i]) {
+            printf(" %14llu", (unsigned long long)v[i]);
+        } else {
+            printf(" %14s", "n/a");
+        }
+    }
+
+    if (on[0] && on[1] && v[0] > 0) {
+        printf(" %6.2f", (double)v[1] / v[0]);
+    } else {
+        printf(" %6s", "n/a");
+    }
+
+    if (on[1] && on[2] && v[1] > 0) {
+        printf(" %8.2f", 1e3 * v[2] / v[1]);
+    } else {
+        printf(" %8s", "n/a");
+    }
+
+    printf("\n");
+}
+
+void TaskLab::ctr_report(const std::vector<tenant_t*>& tn) {
+    std::lock_guard<std::mutex> l(c_lock);
+
+    uint64_t run[NCTR] = { 0 }, task[NCTR] = { 0 }, rt[NCTR];
+    bool     on[NCTR]  = { false };
+    bool     muxed     = false;
+
+    std::vector< std::vector<uint64_t> > thr(c_grp.size(),
+                                             std::vector<uint64_t>(NCTR));
+
+    /* -- Events of every thread since its group was opened */
+    for (size_t t = 0; t < c_grp.size(); t++) {
+        cgrp_t* g = c_grp[t];
+
+        read_group(g, thr[t].data());
+
+        for (int i = 0; i < NCTR; i++) {
+            thr[t][i] -= g->base[i];
+            run[i]    += thr[t][i];
+            on[i]      = on[i] || g->pos[i] != NONE;
+        }
+
+        muxed = muxed || g->muxed;
+    }
+
+    /* -- Events within tasks, the rest being the runtime's */
+    for (size_t g = 0; g < tn.size(); g++) {
+        const plan_t* p = tn[g]->pl;
+
+        for (uint32_t t = 0; t < p->ntasks; t++) {
+            for (int i = 0; i < NCTR; i++) {
+                task[i] += p->t_ctr[(size_t)NCTR * t + i];
+            }
+        }
+    }
+
+    for (int i = 0; i < NCTR; i++) {
+        rt[i] = run[i] > task[i] ? run[i] - task[i] : 0;
+    }
+
+    printf("--- Hardware counters\n");
+    printf("\t\t%-12s", "");
+
+    for (int i = 0; i < NCTR; i++) {
+        printf(" %14s", events[i].name);
+    }
+
+    printf(" %6s %8s\n", "IPC", "MPKI");
+
+    crow("run", run, on);
+    crow("tasks", task, on);
+    crow("runtime", rt, on);
+
+    char label[32];
+
+    for (size_t t = 0; t < c_grp.size(); t++) {
+        if (c_grp[t]->tid == c_disp) {
+            sprintf(label, "dispatcher");
+        } else if (c_grp[t]->gtid == NONE) {
+            sprintf(label, "idle %d", c_grp[t]->tid);
+        } else {
+            sprintf(label, "worker %d", c_grp[t]->gtid);
+        }
+
+        crow(label, thr[t].data(), on);
+    }
+
+    if (muxed) {
+        printf("\t(counters were multiplexed, i.e. counts are partial)\n");
+    }
+
+    /* -- The run is over, and so are its groups */
+    for (size_t t = 0; t < c_grp.size(); t++) {
+        close_group(c_grp[t]);
+    }
+
+    c_grp.clear();
+
+    c_busy = false;
+}
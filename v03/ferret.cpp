@@ -17,9 +17,11 @@
 #define INVALID 0
 #define EXIT   -1
 
-typedef enum { UINT, FLOAT, RUNTIME, EVENT, PLOT, TRACE, BURNIN } tp;
+typedef enum { UINT, FLOAT, RUNTIME, EVENT, PLOT, TRACE, BURNIN, DIST, CORR, STREAM, DISPATCH, BOOL, ARRIVAL, LAYOUT, KERNEL, AFFINITY, PLACEMENT, SHAPE, SUBMIT } tp;
 typedef enum { APP = 1, TG = 2 } tr;
 typedef enum { RANDOM = 1, DATA = 2 } bi;
+typedef enum { GEN = 1, RUN = 2 } st;
+typedef enum { YES = 1, NO = 2 } ans;
 
 /* ************************
  * Software interface
@@ -28,12 +30,22 @@ typedef enum { RANDOM = 1, DATA = 2 } bi;
 void instructions() {
     std::cout << "Available options:\n";
     std::cout << " \"generate\" or \"g\" in order to generate a random task graph;\n";
+    std::cout << " \"layered\"  or \"l\" in order to generate a task graph of given work and span;\n";
+    std::cout << " \"nested\"   or \"n\" in order to generate a task graph whose tasks spawn their subproblems;\n";
     std::cout << " \"run\"      or \"r\" in order to run a current loaded task graph;\n";
+    std::cout << " \"along\"    or \"a\" in order to run a current loaded task graph alongside saved ones;\n";
+    std::cout << " \"load\"     or \"o\" in order to run a current loaded task graph at increasing offered loads;\n";
     std::cout << " \"burnin\"   or \"b\" in order to run multiple task graphs (from randomly generated task graphs to data files);\n";
+    std::cout << " \"stream\"   or \"w\" in order to generate or run a task graph larger than memory;\n";
+    std::cout << " \"table\"    or \"d\" in order to simulate a current loaded task graph on a hardware dependency table;\n";
+    std::cout << " \"micro\"    or \"m\" in order to measure the cost of the runtime primitives;\n";
     std::cout << " \"trace\"    or \"t\" in order to trace a program or a task graph;\n";
+    std::cout << " \"config\"   or \"c\" to set how task graphs are run;\n";
     std::cout << " \"save\"     or \"s\" to save a current loaded task graph;\n";
     std::cout << " \"restore\"  or \"x\" to restore and load a saved task graph;\n";
-    std::cout << " \"plot\"     or \"p\" to plot a current loaded task graph.\n";
+    std::cout << " \"plot\"     or \"p\" to plot a current loaded task graph;\n";
+    std::cout << " \"fit\"      or \"f\" to save the statistics of a current loaded task graph;\n";
+    std::cout << " \"synth\"    or \"y\" to generate a task graph from saved statistics.\n";
 }
 
 /* Set welcome message */
@@ -137,6 +149,144 @@ int read(const char* str, bool opt, uint8_t t, T* r) {
                 *r = tr::TG;
 
             }
+        } else if (t == tp::DIST) {
+            if (strcasecmp("UNIFORM", buf) == 0) {
+                *r = Dist::UNIFORM;
+            } else if (strcasecmp("NORMAL", buf) == 0) {
+                *r = Dist::NORMAL;
+            } else if (strcasecmp("LOGNORMAL", buf) == 0) {
+                *r = Dist::LOGNORMAL;
+            } else if (strcasecmp("EXPONENTIAL", buf) == 0) {
+                *r = Dist::EXPONENTIAL;
+            } else if (strcasecmp("PARETO", buf) == 0) {
+                *r = Dist::PARETO;
+            } else if (strcasecmp("BIMODAL", buf) == 0) {
+                *r = Dist::BIMODAL;
+            } else if (strcasecmp("EMPIRICAL", buf) == 0) {
+                *r = Dist::EMPIRICAL;
+            }
+
+        } else if (t == tp::CORR) {
+            if (strcasecmp("DEPS", buf) == 0 ||
+                strcasecmp("DEPENDENCIES", buf) == 0) {
+                *r = Corr::NDEPS;
+            } else if (strcasecmp("DEPTH", buf) == 0) {
+                *r = Corr::DEPTH;
+            }
+
+        } else if (t == tp::DISPATCH) {
+            if (strcasecmp("SERIAL", buf) == 0) {
+                *r = Dispatch::SERIAL;
+            } else if (strcasecmp("LEVEL", buf) == 0) {
+                *r = Dispatch::LEVEL;
+            } else if (strcasecmp("RANGE", buf) == 0) {
+                *r = Dispatch::RANGE;
+            }
+
+        } else if (t == tp::KERNEL) {
+            if (strcasecmp("SPIN", buf) == 0) {
+                *r = Kernel::SPIN;
+            } else if (strcasecmp("FMA", buf) == 0) {
+                *r = Kernel::FMA;
+            } else if (strcasecmp("TRIAD", buf) == 0) {
+                *r = Kernel::TRIAD;
+            } else if (strcasecmp("CHASE", buf) == 0) {
+                *r = Kernel::CHASE;
+            } else if (strcasecmp("THRASH", buf) == 0) {
+                *r = Kernel::THRASH;
+            } else if (strcasecmp("MIX", buf) == 0) {
+                *r = Kernel::MIX;
+            }
+
+        } else if (t == tp::AFFINITY) {
+            if (strcasecmp("FREE", buf) == 0) {
+                *r = Affinity::FREE;
+            } else if (strcasecmp("COMPACT", buf) == 0) {
+                *r = Affinity::COMPACT;
+            } else if (strcasecmp("SPREAD", buf) == 0 ||
+                       strcasecmp("SCATTER", buf) == 0) {
+                *r = Affinity::SPREAD;
+            } else if (strcasecmp("LIST", buf) == 0) {
+                *r = Affinity::CPUS;
+            }
+
+        } else if (t == tp::PLACEMENT) {
+            if (strcasecmp("LEAVE", buf) == 0) {
+                *r = Placement::LEAVE;
+            } else if (strcasecmp("TOUCH", buf) == 0 ||
+                       strcasecmp("FIRST TOUCH", buf) == 0) {
+                *r = Placement::TOUCH;
+            } else if (strcasecmp("INTERLEAVE", buf) == 0) {
+                *r = Placement::INTERLEAVE;
+            } else if (strcasecmp("BIND", buf) == 0) {
+                *r = Placement::BIND;
+            }
+
+        } else if (t == tp::SHAPE) {
+            if (strcasecmp("FIB", buf) == 0 ||
+                strcasecmp("FIBONACCI", buf) == 0) {
+                *r = Shape::FIB;
+            } else if (strcasecmp("QSORT", buf) == 0 ||
+                       strcasecmp("QUICKSORT", buf) == 0) {
+                *r = Shape::QSORT;
+            } else if (strcasecmp("BH", buf) == 0 ||
+                       strcasecmp("BARNES-HUT", buf) == 0) {
+                *r = Shape::BHTREE;
+            }
+
+        } else if (t == tp::SUBMIT) {
+            if (strcasecmp("INTERLEAVED", buf) == 0 ||
+                strcasecmp("i", buf) == 0) {
+                *r = Mix::INTERLEAVED;
+            } else if (strcasecmp("PRODUCERS", buf) == 0 ||
+                       strcasecmp("p", buf) == 0) {
+                *r = Mix::PER_PRODUCER;
+            }
+
+        } else if (t == tp::LAYOUT) {
+            if (strcasecmp("DENSE", buf) == 0) {
+                *r = Layout::DENSE;
+            } else if (strcasecmp("PADDED", buf) == 0) {
+                *r = Layout::PADDED;
+            } else if (strcasecmp("PAGE", buf) == 0) {
+                *r = Layout::PAGE;
+            } else if (strcasecmp("POW2", buf) == 0) {
+                *r = Layout::POW2;
+            } else if (strcasecmp("SCATTER", buf) == 0) {
+                *r = Layout::SCATTER;
+            } else if (strcasecmp("REGION", buf) == 0) {
+                *r = Layout::REGION;
+            }
+
+        } else if (t == tp::ARRIVAL) {
+            if (strcasecmp("CLOSED", buf) == 0) {
+                *r = Arrival::CLOSED;
+            } else if (strcasecmp("CONSTANT", buf) == 0) {
+                *r = Arrival::CONSTANT;
+            } else if (strcasecmp("POISSON", buf) == 0) {
+                *r = Arrival::POISSON;
+            } else if (strcasecmp("BURSTY", buf) == 0) {
+                *r = Arrival::BURSTY;
+            }
+
+        } else if (t == tp::BOOL) {
+            if (strcasecmp("Yes", buf) == 0 ||
+                strcasecmp("y", buf) == 0) {
+                *r = ans::YES;
+            } else if (strcasecmp("No", buf) == 0 ||
+                strcasecmp("n", buf) == 0) {
+                *r = ans::NO;
+            }
+
+        } else if (t == tp::STREAM) {
+            if (strcasecmp("Generate", buf) == 0 ||
+                strcasecmp("g", buf) == 0) {
+                *r = st::GEN;
+            } else if (strcasecmp("Run", buf) == 0 ||
+                strcasecmp("r", buf) == 0) {
+                *r = st::RUN;
+            }
+
         } else if (t == tp::BURNIN) {
             if (strcasecmp("Random", buf) == 0 || 
                 strcasecmp("r", buf) == 0) {
@@ -225,6 +375,82 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
 
                 check(&exec_range, DEFAULT_EXECUTION_RANGE);
 
+                /* Duration model */
+                dmodel dm;
+
+                sprintf(buf, "\tDistribution of task durations (uniform, normal, \
+lognormal, exponential, pareto, bimodal or empirical): (OPTIONAL, default is \
+uniform) ");
+                if (read(buf, true, tp::DIST, &dm.dist) == EXIT) {
+                    break;
+                }
+
+                check(&dm.dist, (uint8_t)Dist::UNIFORM);
+
+                if (dm.dist == Dist::NORMAL || dm.dist == Dist::LOGNORMAL) {
+                    sprintf(buf, "\tStandard deviation (sigma for lognormal): \
+(OPTIONAL, default is %0.2f) ", exec_range);
+                    if (read(buf, true, tp::FLOAT, &dm.spread) == EXIT) {
+                        break;
+                    }
+
+                } else if (dm.dist == Dist::PARETO) {
+                    sprintf(buf, "\tTail index, greater than 1: (OPTIONAL, \
+default is %0.2f) ", DEFAULT_PARETO_SHAPE);
+                    if (read(buf, true, tp::FLOAT, &dm.shape) == EXIT) {
+                        break;
+                    }
+
+                    check(&dm.shape, DEFAULT_PARETO_SHAPE);
+
+                } else if (dm.dist == Dist::BIMODAL) {
+                    sprintf(buf, "\tFraction of long tasks (0-1): (OPTIONAL, \
+default is %0.2f) ", DEFAULT_BIMODAL_FRAC);
+                    if (read(buf, true, tp::FLOAT, &dm.frac) == EXIT) {
+                        break;
+                    }
+
+                    check(&dm.frac, DEFAULT_BIMODAL_FRAC);
+
+                    sprintf(buf, "\tHow many times longer are long tasks: \
+(OPTIONAL, default is %0.2f) ", DEFAULT_BIMODAL_RATIO);
+                    if (read(buf, true, tp::FLOAT, &dm.ratio) == EXIT) {
+                        break;
+                    }
+
+                    check(&dm.ratio, DEFAULT_BIMODAL_RATIO);
+
+                } else if (dm.dist == Dist::EMPIRICAL) {
+                    char h_path[256];
+
+                    std::cout << "\tHistogram file (\"lo hi weight\" per line): ";
+                    std::cin >> h_path;
+
+                    /* Garbage */
+                    getchar();
+
+                    if (!dm.load(h_path)) {
+                        break;
+                    }
+                }
+
+                sprintf(buf, "\tCorrelate durations with (deps or depth): \
+(OPTIONAL, default is none) ");
+                if (read(buf, true, tp::CORR, &dm.corr) == EXIT) {
+                    break;
+                }
+
+                if (dm.corr != Corr::FLAT) {
+                    sprintf(buf, "\tStrength of the correlation (0-1): ");
+                    if (read(buf, false, tp::FLOAT, &dm.weight) == EXIT) {
+                        break;
+                    }
+                }
+
+                if (!tl.duration(dm)) {
+                    break;
+                }
+
                 // Generate graph
                 tl.generate(num_tasks, max_dep, dep_range, exec_time, 
                             exec_range);
@@ -234,6 +460,120 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
 
                 break;
 
+            case 'l':
+                /* Generate layered task graph */
+                {
+                uint32_t num_tasks;
+                double   work, span;
+                float    density;
+
+                std::vector<float> widths;
+
+                sprintf(buf, "\tNumber of tasks to be generated: ");
+                if (read(buf, false, tp::UINT, &num_tasks) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tTotal work, i.e. amount of iterations of all \
+tasks: ");
+                if (read(buf, false, tp::FLOAT, &work) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tSpan, i.e. amount of iterations along the \
+critical path: (OPTIONAL, give a width profile instead) ");
+                if (read(buf, true, tp::FLOAT, &span) == EXIT) {
+                    break;
+                }
+
+                if (span == INVALID) {
+                    char  w_path[256];
+                    float w;
+
+                    std::cout << "\tWidth profile (relative width per line): ";
+                    std::cin >> w_path;
+
+                    /* Garbage */
+                    getchar();
+
+                    std::ifstream ifs(w_path);
+                    while (ifs >> w) {
+                        widths.push_back(w);
+                    }
+
+                    if (widths.empty()) {
+                        std::cout << "\t\t\"" << w_path << "\" is an invalid \
+width profile.\n";
+                        break;
+                    }
+                }
+
+                sprintf(buf, "\tEdge density, i.e. avg. no. of predecessors \
+per task: ");
+                if (read(buf, false, tp::FLOAT, &density) == EXIT) {
+                    break;
+                }
+
+                if (tl.layered(num_tasks, work, span, density,
+                               widths.empty() ? NULL : &widths)) {
+                    std::cout << "Task graph successfully generated!\n";
+                }
+                }
+
+                break;
+
+            case 'n':
+                /* Generate nested task graph */
+                {
+                uint8_t  shape, wait;
+                uint32_t size, cutoff, exec_time, df;
+
+                sprintf(buf, "\tRecursive problem (fib, qsort or bh): ");
+                if (read(buf, false, tp::SHAPE, &shape) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\t%s: ", shape == Shape::FIB ? "Fibonacci \
+argument" : shape == Shape::QSORT ? "Number of elements to sort" : "Number of \
+bodies");
+                if (read(buf, false, tp::UINT, &size) == EXIT) {
+                    break;
+                }
+
+                df = shape == Shape::FIB ? DEFAULT_FIB_CUTOFF :
+                     shape == Shape::QSORT ? DEFAULT_SORT_CUTOFF : DEFAULT_BH_LEAF;
+
+                sprintf(buf, "\tSize below which tasks do not spawn any task: \
+(OPTIONAL, default is %d) ", df);
+                if (read(buf, true, tp::UINT, &cutoff) == EXIT) {
+                    break;
+                }
+
+                check(&cutoff, df);
+
+                sprintf(buf, "\tShould tasks wait for the tasks they spawn? \
+(OPTIONAL, default is yes) ");
+                if (read(buf, true, tp::BOOL, &wait) == EXIT) {
+                    break;
+                }
+
+                check(&wait, (uint8_t)ans::YES);
+
+                sprintf(buf, "\tStandard execution per task, i.e. amount of \
+iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
+                if (read(buf, true, tp::UINT, &exec_time) == EXIT) {
+                    break;
+                }
+
+                check(&exec_time, DEFAULT_EXECUTION_SIZE);
+
+                if (tl.nested(shape, size, cutoff, wait == ans::YES, exec_time)) {
+                    std::cout << "Task graph successfully generated!\n";
+                }
+                }
+
+                break;
+
             case 'r':
                 {
                 uint8_t rt;
@@ -249,6 +589,88 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
 
                 break;
 
+            case 'a':
+                {
+                std::vector<TaskLab*> labs(1, &tl);
+                uint8_t               mix, rt;
+
+                /* Every other graph is restored on a lab of its own, and run
+                 * as the current one */
+                while (true) {
+                    std::cout << "\tTask graph to be run alongside (without \
+extension, empty when done): ";
+
+                    fgets(buf, 256, stdin);
+
+                    /* Get rid of garbage */
+                    buf[strlen(buf) - 1] = '\0';
+
+                    if (buf[0] == '\0') {
+                        break;
+                    }
+
+                    TaskLab* l = new TaskLab();
+
+                    if (l->restore(buf)) {
+                        l->configure(tl.config());
+
+                        labs.push_back(l);
+                    } else {
+                        delete l;
+                    }
+                }
+
+                sprintf(buf, "\tInterleaved (from a single thread) or \
+producers (one per graph): ");
+                if (read(buf, false, tp::SUBMIT, &mix) == EXIT) {
+                    mix = INVALID;
+                }
+
+                if (mix != INVALID) {
+                    sprintf(buf, "\tRuntime to be run: ");
+                    if (read(buf, false, tp::RUNTIME, &rt) == EXIT) {
+                        mix = INVALID;
+                    }
+                }
+
+                /* Run! */
+                if (mix != INVALID) {
+                    TaskLab::run(labs, rt, mix);
+                }
+
+                for (size_t k = 1; k < labs.size(); k++) {
+                    delete labs[k];
+                }
+                }
+
+                break;
+
+            case 'o':
+                {
+                uint8_t  rt;
+                float    max_r;
+                uint32_t steps;
+
+                sprintf(buf, "\tRuntime to be run: ");
+                if (read(buf, false, tp::RUNTIME, &rt) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tHighest offered load (tasks/s): ");
+                if (read(buf, false, tp::FLOAT, &max_r) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tNumber of loads up to it: ");
+                if (read(buf, false, tp::UINT, &steps) == EXIT) {
+                    break;
+                }
+
+                tl.load_curve(rt, max_r, steps);
+                }
+
+                break;
+
             case 'b':
                 {
                 uint8_t bi_t;
@@ -261,6 +683,7 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
                 if (bi_t == RANDOM) {
                     uint32_t nruns;
                     uint32_t max_t;
+                    uint32_t jobs = 1;
                     uint8_t  rt;
 
                     sprintf(buf, "\tNumber of graphs to be generated: ");
@@ -278,11 +701,17 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
                         break;
                     }
 
-                    tl.burnin(nruns, max_t, rt);
+                    sprintf(buf, "\tNo. of graphs run at once: (OPTIONAL, default is 1) ");
+                    if (read(buf, true, tp::UINT, &jobs) == EXIT) {
+                        break;
+                    }
+
+                    tl.burnin(nruns, max_t, rt, std::max(jobs, (uint32_t)1));
 
                 } else {
                     char a_path[256];
                     uint32_t nruns;
+                    uint32_t jobs = 1;
                     uint8_t  rt;
 
                     std::cout << "\tPath of the database: ";
@@ -301,13 +730,286 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
                         break;
                     }
 
-                    tl.burnin(a_path, nruns, rt);
+                    sprintf(buf, "\tNo. of files run at once: (OPTIONAL, default is 1) ");
+                    if (read(buf, true, tp::UINT, &jobs) == EXIT) {
+                        break;
+                    }
+
+                    tl.burnin(a_path, nruns, rt, std::max(jobs, (uint32_t)1));
 
                 }
                 }
 
                 break;
 
+            case 'w':
+                {
+                uint8_t  o;
+                char     a_path[256];
+
+                sprintf(buf, "\tGenerate or run (streams a task graph from/to a .sdat file): ");
+                if (read(buf, false, tp::STREAM, &o) == EXIT) {
+                    break;
+                }
+
+                std::cout << "\tStreamed task graph file (without extension): ";
+                std::cin >> a_path;
+
+                /* Garbage */
+                getchar();
+
+                if (o == GEN) {
+                    uint32_t num_tasks, max_dep, dep_range, exec_time;
+                    float    exec_range;
+
+                    sprintf(buf, "\tNumber of tasks to be generated: ");
+                    if (read(buf, false, tp::UINT, &num_tasks) == EXIT) {
+                        break;
+                    }
+
+                    sprintf(buf, "\tMaximum number of IN/INOUT dependencies: ");
+                    if (read(buf, false, tp::UINT, &max_dep) == EXIT) {
+                        break;
+                    }
+
+                    sprintf(buf, "\tHow far a predecessor may be from a parent: \
+(OPTIONAL, default is %d) ", DEFAULT_DEP_RANGE);
+                    if (read(buf, true, tp::UINT, &dep_range) == EXIT) {
+                        break;
+                    }
+
+                    check(&dep_range, DEFAULT_DEP_RANGE);
+
+                    sprintf(buf, "\tStandard execution per task, i.e. amount of \
+iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
+                    if (read(buf, true, tp::UINT, &exec_time) == EXIT) {
+                        break;
+                    }
+
+                    check(&exec_time, DEFAULT_EXECUTION_SIZE);
+
+                    sprintf(buf, "\tMax. range from standard execution size (0-1): \
+(OPTIONAL, default is %0.2f) ", DEFAULT_EXECUTION_RANGE);
+                    if (read(buf, true, tp::FLOAT, &exec_range) == EXIT) {
+                        break;
+                    }
+
+                    check(&exec_range, DEFAULT_EXECUTION_RANGE);
+
+                    if (tl.stream(a_path, num_tasks, max_dep, dep_range,
+                                  exec_time, exec_range)) {
+                        std::cout << "Task graph successfully streamed to \""
+                                  << a_path << ".sdat\".\n";
+                    }
+                } else {
+                    uint32_t window;
+                    uint8_t  rt;
+
+                    sprintf(buf, "\tMax. no. of in-flight tasks: (OPTIONAL, \
+default is %d) ", DEFAULT_WINDOW);
+                    if (read(buf, true, tp::UINT, &window) == EXIT) {
+                        break;
+                    }
+
+                    check(&window, DEFAULT_WINDOW);
+
+                    sprintf(buf, "\tRuntime to be run: ");
+                    if (read(buf, false, tp::RUNTIME, &rt) == EXIT) {
+                        break;
+                    }
+
+                    tl.run(a_path, rt, window);
+                }
+                }
+
+                break;
+
+            case 'c':
+                {
+                rcfg cfg = tl.config();
+                char opt[256];
+
+                std::cout << "\tOption to be set (dispatch, producers, chunk, validate, \
+analyze, lag, arrival, rate, burst, window, window_deps, layout, stride, \
+region, payload, kernel, wset, counters, affinity, placement, node, \
+iterations or overlap): ";
+                fgets(opt, 256, stdin);
+
+                /* Garbage */
+                opt[strlen(opt) - 1] = '\0';
+
+                if (strcasecmp("dispatch", opt) == 0) {
+                    sprintf(buf, "\tHow tasks are created (serial, level or \
+range): ");
+                    if (read(buf, false, tp::DISPATCH, &cfg.dispatch) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("producers", opt) == 0) {
+                    sprintf(buf, "\tNumber of threads creating tasks: ");
+                    if (read(buf, false, tp::UINT, &cfg.producers) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("chunk", opt) == 0) {
+                    sprintf(buf, "\tNumber of tasks claimed at once by a \
+producer: ");
+                    if (read(buf, false, tp::UINT, &cfg.chunk) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("validate", opt) == 0) {
+                    uint8_t v;
+
+                    sprintf(buf, "\tValidate dependencies while running \
+(yes or no): ");
+                    if (read(buf, false, tp::BOOL, &v) == EXIT) {
+                        break;
+                    }
+
+                    cfg.validate = v == ans::YES;
+                } else if (strcasecmp("analyze", opt) == 0) {
+                    uint8_t v;
+
+                    sprintf(buf, "\tReport lost parallelism after runs \
+(yes or no): ");
+                    if (read(buf, false, tp::BOOL, &v) == EXIT) {
+                        break;
+                    }
+
+                    cfg.analyze = v == ans::YES;
+                } else if (strcasecmp("lag", opt) == 0) {
+                    sprintf(buf, "\tStart lag from which a task is late \
+(us): ");
+                    if (read(buf, false, tp::UINT, &cfg.lag) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("arrival", opt) == 0) {
+                    sprintf(buf, "\tHow tasks arrive (closed, constant, poisson \
+or bursty): ");
+                    if (read(buf, false, tp::ARRIVAL, &cfg.arrival) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("rate", opt) == 0) {
+                    sprintf(buf, "\tOffered load (tasks/s): ");
+                    if (read(buf, false, tp::FLOAT, &cfg.rate) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("burst", opt) == 0) {
+                    sprintf(buf, "\tNumber of tasks arriving at once: ");
+                    if (read(buf, false, tp::UINT, &cfg.burst) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("window", opt) == 0) {
+                    sprintf(buf, "\tMax. number of in-flight tasks: \
+(OPTIONAL, default is unbounded) ");
+                    if (read(buf, true, tp::UINT, &cfg.max_tasks) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("window_deps", opt) == 0) {
+                    sprintf(buf, "\tMax. number of in-flight dependencies: \
+(OPTIONAL, default is unbounded) ");
+                    if (read(buf, true, tp::UINT, &cfg.max_deps) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("layout", opt) == 0) {
+                    sprintf(buf, "\tWhere variables are placed (dense, padded, \
+page, pow2, scatter or region): ");
+                    if (read(buf, false, tp::LAYOUT, &cfg.layout) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("stride", opt) == 0) {
+                    sprintf(buf, "\tBytes between variables of pow2 layouts: ");
+                    if (read(buf, false, tp::UINT, &cfg.stride) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("region", opt) == 0) {
+                    sprintf(buf, "\tMax. length of variables of region \
+layouts (at least the payload): ");
+                    if (read(buf, false, tp::UINT, &cfg.region) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("payload", opt) == 0) {
+                    sprintf(buf, "\tBytes of data of every variable: \
+(OPTIONAL, default is none) ");
+                    if (read(buf, true, tp::UINT, &cfg.payload) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("kernel", opt) == 0) {
+                    sprintf(buf, "\tWork done by tasks (spin, fma, triad, \
+chase, thrash or mix): ");
+                    if (read(buf, false, tp::KERNEL, &cfg.kernel) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("wset", opt) == 0) {
+                    sprintf(buf, "\tMemory of each thread for triad and chase \
+kernels (MB): ");
+                    if (read(buf, false, tp::UINT, &cfg.wset) == EXIT) {
+                        break;
+                    }
+
+                    cfg.wset <<= 20;
+                } else if (strcasecmp("counters", opt) == 0) {
+                    uint8_t v;
+
+                    sprintf(buf, "\tCount hardware events of runs and tasks \
+(yes or no): ");
+                    if (read(buf, false, tp::BOOL, &v) == EXIT) {
+                        break;
+                    }
+
+                    cfg.counters = v == ans::YES;
+                } else if (strcasecmp("affinity", opt) == 0) {
+                    sprintf(buf, "\tWhere threads run (free, compact, spread \
+or list): ");
+                    if (read(buf, false, tp::AFFINITY, &cfg.affinity) == EXIT) {
+                        break;
+                    }
+
+                    if (cfg.affinity == Affinity::CPUS) {
+                        char cpus[256];
+
+                        std::cout << "\tCPU of each thread (e.g. 0-3,8): ";
+                        fgets(cpus, 256, stdin);
+
+                        /* Garbage */
+                        cpus[strlen(cpus) - 1] = '\0';
+
+                        cfg.cpus = cpus;
+                    }
+                } else if (strcasecmp("placement", opt) == 0) {
+                    sprintf(buf, "\tWhere variables live (leave, touch, \
+interleave or bind): ");
+                    if (read(buf, false, tp::PLACEMENT, &cfg.placement) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("iterations", opt) == 0) {
+                    sprintf(buf, "\tTimes each run replays the graph: ");
+                    if (read(buf, false, tp::UINT, &cfg.iters) == EXIT) {
+                        break;
+                    }
+                } else if (strcasecmp("overlap", opt) == 0) {
+                    uint8_t v;
+
+                    sprintf(buf, "\tOverlap replays instead of waiting for \
+each one (yes or no): ");
+                    if (read(buf, false, tp::BOOL, &v) == EXIT) {
+                        break;
+                    }
+
+                    cfg.overlap = v == ans::YES;
+                } else if (strcasecmp("node", opt) == 0) {
+                    sprintf(buf, "\tNUMA node holding variables when bound: ");
+                    if (read(buf, true, tp::UINT, &cfg.node) == EXIT) {
+                        break;
+                    }
+                } else {
+                    std::cout << "\t\t\"" << opt << "\" is an invalid option.\n";
+                    break;
+                }
+
+                tl.configure(cfg);
+                }
+
+                break;
+
             case 't':
                 {
                 uint8_t o, e, rt;
@@ -434,6 +1136,119 @@ iterations: (OPTIONAL, default is %d) ", DEFAULT_EXECUTION_SIZE);
 
                 break;
 
+            case 'd':
+                {
+                tcfg     tc;
+                uint32_t workers = tc.workers;
+
+                sprintf(buf, "\tNumber of sets of the dependency table: \
+(OPTIONAL, default is %u) ", DEFAULT_SETS);
+                if (read(buf, true, tp::UINT, &tc.sets) == EXIT) {
+                    break;
+                }
+                check(&tc.sets, (uint32_t)DEFAULT_SETS);
+
+                sprintf(buf, "\tNumber of entries per set: \
+(OPTIONAL, default is %u) ", DEFAULT_WAYS);
+                if (read(buf, true, tp::UINT, &tc.ways) == EXIT) {
+                    break;
+                }
+                check(&tc.ways, (uint32_t)DEFAULT_WAYS);
+
+                sprintf(buf, "\tNumber of task queue entries: \
+(OPTIONAL, default is %u) ", DEFAULT_QUEUE);
+                if (read(buf, true, tp::UINT, &tc.queue) == EXIT) {
+                    break;
+                }
+                check(&tc.queue, (uint32_t)DEFAULT_QUEUE);
+
+                sprintf(buf, "\tMax. number of dependencies per task: \
+(OPTIONAL, default is %u) ", DEFAULT_TDEPS);
+                if (read(buf, true, tp::UINT, &tc.max_deps) == EXIT) {
+                    break;
+                }
+                check(&tc.max_deps, (uint32_t)DEFAULT_TDEPS);
+
+                sprintf(buf, "\tNumber of workers: (OPTIONAL, default is %u) ",
+                        workers);
+                if (read(buf, true, tp::UINT, &tc.workers) == EXIT) {
+                    break;
+                }
+                check(&tc.workers, workers);
+
+                tl.simulate(tc);
+                }
+
+                break;
+
+            case 'm':
+                {
+                uint8_t  rt;
+                uint32_t reps;
+
+                sprintf(buf, "\tRuntime to be measured: ");
+                if (read(buf, false, tp::RUNTIME, &rt) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tRepetitions of each benchmark: \
+(OPTIONAL, default is %u) ", BENCH_REPS);
+                if (read(buf, true, tp::UINT, &reps) == EXIT) {
+                    break;
+                }
+                check(&reps, BENCH_REPS);
+
+                tl.bench(rt, reps);
+                }
+
+                break;
+
+            case 'f':
+                {
+                std::cout << "\tSave statistics as (without extension): ";
+                std::cin >> buf;
+
+                /* Garbage */
+                getchar();
+
+                if (tl.profile(buf)) {
+                    std::cout << "Statistics successfully saved as \"" << buf
+                              << ".prof\".\n";
+                }
+                }
+
+                break;
+
+            case 'y':
+                {
+                char     p_path[256];
+                uint32_t num_tasks;
+                uint32_t span;
+
+                std::cout << "\tStatistics to be matched (without extension): ";
+                std::cin >> p_path;
+
+                /* Garbage */
+                getchar();
+
+                sprintf(buf, "\tNumber of tasks to be generated: ");
+                if (read(buf, false, tp::UINT, &num_tasks) == EXIT) {
+                    break;
+                }
+
+                sprintf(buf, "\tKeep the span and widen levels (1) or keep \
+the level widths (0): (OPTIONAL, default is 0) ");
+                if (read(buf, true, tp::UINT, &span) == EXIT) {
+                    break;
+                }
+
+                if (tl.synthesize(p_path, num_tasks, span != 0)) {
+                    std::cout << "Task graph successfully synthesized!\n";
+                }
+                }
+
+                break;
+
             case 'h':
                 /* Help*/
                 instructions();
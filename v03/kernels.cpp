@@ -0,0 +1,225 @@
+/**
+ * Kernels.cpp
+ *   Work done by tasks, each kernel stressing a different part of the
+ *   machine: functional units, memory bandwidth, memory latency or caches
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <immintrin.h>
+
+/* ************************
+ * Per thread memory
+ * ************************ */
+/**
+ * Memory of the current thread, kept across tasks so that kernels carry on
+ * where the previous task left off
+ */
+typedef struct thread_memory {
+    std::vector<double>   a, b, c;    // TRIAD arrays
+    uint64_t              t_pos = 0;
+    std::vector<uint64_t> ring;       // CHASE cycle, one node per cache line
+    uint64_t              c_pos = 0;
+    std::vector<uint64_t> set;        // THRASH working set
+    uint64_t              s_pos = 0;
+} tmem_t;
+
+static thread_local tmem_t mem;
+
+/* ************************
+ * Compute bound
+ * ************************ */
+/* Independent accumulators, so that FMAs are bound by throughput rather than
+ * by latency */
+__attribute__((target("avx512f")))
+static uint64_t fma_avx512(const long load) {
+    __m512 a0 = _mm512_set1_ps(1.0f), a1 = a0, a2 = a0, a3 = a0;
+    __m512 b  = _mm512_set1_ps(0.999999f);
+    __m512 c  = _mm512_set1_ps(1e-6f);
+    float  r[16];
+
+    for (long i = 0; i < load; i += 64) {
+        a0 = _mm512_fmadd_ps(a0, b, c);
+        a1 = _mm512_fmadd_ps(a1, b, c);
+        a2 = _mm512_fmadd_ps(a2, b, c);
+        a3 = _mm512_fmadd_ps(a3, b, c);
+    }
+
+    a0 = _mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3));
+
+    _mm512_storeu_ps(r, a0);
+
+    return r[0] + r[5] + r[10] + r[15];
+}
+
+__attribute__((target("avx2,fma")))
+static uint64_t fma_avx2(const long load) {
+    __m256 a0 = _mm256_set1_ps(1.0f), a1 = a0, a2 = a0, a3 = a0;
+    __m256 b  = _mm256_set1_ps(0.999999f);
+    __m256 c  = _mm256_set1_ps(1e-6f);
+    float  r[8];
+
+    for (long i = 0; i < load; i += 32) {
+        a0 = _mm256_fmadd_ps(a0, b, c);
+        a1 = _mm256_fmadd_ps(a1, b, c);
+        a2 = _mm256_fmadd_ps(a2, b, c);
+        a3 = _mm256_fmadd_ps(a3, b, c);
+    }
+
+    a0 = _mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3));
+
+    _mm256_storeu_ps(r, a0);
+
+    return r[0] + r[1] + r[2] + r[3] + r[4] + r[5] + r[6] + r[7];
+}
+
+static uint64_t fma_scalar(const long load) {
+    float a[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+    for (long i = 0; i < load; i += 8) {
+        for (int l = 0; l < 8; l++) {
+            a[l] = a[l] * 0.999999f + 1e-6f;
+        }
+    }
+
+    return a[0] + a[1] + a[2] + a[3] + a[4] + a[5] + a[6] + a[7];
+}
+
+/* One FMA per unit of load, on the widest vectors available */
+static uint64_t fmadd(const long load) {
+    static const int isa = __builtin_cpu_supports("avx512f") ? 2 :
+                           __builtin_cpu_supports("avx2") &&
+                           __builtin_cpu_supports("fma") ? 1 : 0;
+
+    return isa == 2 ? fma_avx512(load) :
+           isa == 1 ? fma_avx2(load) : fma_scalar(load);
+}
+
+/* ************************
+ * Memory bound
+ * ************************ */
+/* STREAM triad, one element per unit of load */
+static uint64_t triad(const long load, const uint64_t wset) {
+    uint64_t n = std::max(wset / (3 * sizeof(double)), (uint64_t)1);
+
+    if (mem.a.size() != n) {
+        mem.a.assign(n, 0);
+        mem.b.assign(n, 1);
+        mem.c.assign(n, 2);
+        mem.t_pos = 0;
+    }
+
+    double*  a = mem.a.data();
+    double*  b = mem.b.data();
+    double*  c = mem.c.data();
+    uint64_t j = mem.t_pos;
+
+    for (long i = 0; i < load; ) {
+        uint64_t m = std::min((uint64_t)(load - i), n - j);
+
+        for (uint64_t k = j; k < j + m; k++) {
+            a[k] = b[k] + 3.0 * c[k];
+        }
+
+        i += m;
+        j  = (j + m) % n;
+    }
+
+    mem.t_pos = j;
+
+    return a[j];
+}
+
+/* Dependent loads over a random cycle, one per unit of load */
+static uint64_t chase(const long load, const uint64_t wset) {
+    const uint64_t stride = CACHE_LINE / sizeof(uint64_t);
+    uint64_t       nodes  = std::max(wset / CACHE_LINE, (uint64_t)2);
+
+    if (mem.ring.size() != nodes * stride) {
+        std::vector<uint64_t> perm(nodes);
+        std::mt19937_64       gen(nodes);
+
+        for (uint64_t i = 0; i < nodes; i++) {
+            perm[i] = i;
+        }
+
+        // Sattolo's algorithm, i.e. a single cycle through every node
+        for (uint64_t i = nodes - 1; i > 0; i--) {
+            std::swap(perm[i], perm[gen() % i]);
+        }
+
+        mem.ring.assign(nodes * stride, 0);
+
+        for (uint64_t i = 0; i < nodes; i++) {
+            mem.ring[i * stride] = perm[i] * stride;
+        }
+
+        mem.c_pos = 0;
+    }
+
+    const uint64_t* r = mem.ring.data();
+    uint64_t        p = mem.c_pos;
+
+    for (long i = 0; i < load; i++) {
+        p = r[p];
+    }
+
+    mem.c_pos = p;
+
+    return p;
+}
+
+/* Writes to a working set larger than L2, one cache line per unit of load */
+static uint64_t thrash(const long load) {
+    const uint64_t stride = CACHE_LINE / sizeof(uint64_t);
+    const uint64_t n      = THRASH_SET / sizeof(uint64_t);
+
+    if (mem.set.size() != n) {
+        mem.set.assign(n, 0);
+        mem.s_pos = 0;
+    }
+
+    uint64_t* s = mem.set.data();
+    uint64_t  j = mem.s_pos;
+
+    for (long i = 0; i < load; i++) {
+        s[j] += i;
+        j     = j + stride < n ? j + stride : 0;
+    }
+
+    mem.s_pos = j;
+
+    return s[j];
+}
+
+/* ************************
+ * Kernel selection
+ * ************************ */
+uint8_t kernel_of(const uint8_t k, const uint32_t tID) {
+    if (k != Kernel::MIX) {
+        return k;
+    }
+
+    // Spread neighbouring tasks over kernels
+    return Kernel::SPIN + ((uint32_t)(tID * 2654435761u) >> 16) % Kernel::THRASH;
+}
+
+uint64_t kernel(const uint8_t k, const long load, const uint64_t wset) {
+    switch (k) {
+        case FMA:
+            return fmadd(load);
+
+        case TRIAD:
+            return triad(load, wset);
+
+        case CHASE:
+            return chase(load, wset);
+
+        case THRASH:
+            return thrash(load);
+
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,228 @@
+/**
+ * Nested.cpp
+ *   Nested graphs, i.e. recursion trees of divide-and-conquer problems where
+ *   every task is spawned by its parent instead of by the dispatcher
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cmath>
+#include <array>
+
+/* ************************
+ * Recursion trees
+ * ************************ */
+/**
+ * Subproblem of a recursion tree, waiting to become a task
+ */
+typedef struct nested_node {
+    uint32_t parent;    // task spawning it (NONE: root)
+    uint32_t size;      // fib argument, no. of elements or of bodies
+    uint32_t from;      // first of its bodies (BHTREE)
+    uint32_t depth;     // depth on the octree (BHTREE)
+    double   c[3];      // center of its cube (BHTREE)
+    double   h;         // half the side of its cube (BHTREE)
+} nnode_t;
+
+typedef std::array<double, 3> point;
+
+/* Octant of a cube (centered at c) holding a point, one bit per axis */
+static uint32_t octant(const point& x, const double* c) {
+    return (x[0] >= c[0]) | (x[1] >= c[1]) << 1 | (x[2] >= c[2]) << 2;
+}
+
+bool TaskGraph::create_nested(const uint8_t shape, const uint32_t n,
+                              const uint32_t cutoff, const bool wait) {
+    /* Keep in track with the id of each dependency */
+    uint32_t dep_id = 0;
+
+    std::mt19937                           gen(rand());
+    std::uniform_real_distribution<double> pos(0, 1);
+
+    /* Bodies of the octree, sorted by cube as it is built */
+    std::vector<point> body(shape == Shape::BHTREE ? n : 0);
+
+    for (size_t b = 0; b < body.size(); b++) {
+        body[b] = { { pos(gen), pos(gen), pos(gen) } };
+    }
+
+    std::vector<double>  w;     // work of each task, before normalizing
+    std::vector<nnode_t> stack;
+    nnode_t              root = { (uint32_t)NONE, n, 0, 0, { 0.5, 0.5, 0.5 },
+                                  0.5 };    // unit cube
+
+    tasks.clear();
+    stack.push_back(root);
+
+    ndeps = 0;
+    dep_r = 0;
+
+    /* -- Tasks in preorder, so that parents come before their children */
+    while (!stack.empty()) {
+        nnode_t  nd = stack.back();
+        uint32_t id = tasks.size();
+
+        stack.pop_back();
+
+        if (id >= MAX_NESTED) {
+            tasks.clear();
+            ntasks = nvar = ndeps = 0;
+
+            return false;
+        }
+
+        tasks.push_back(_task());
+
+        tasks[id].tID    = id;
+        tasks[id].parent = nd.parent;
+
+        if (nd.parent != (uint32_t)NONE) {
+            _dep pred;
+
+            pred.task = nd.parent;
+            pred.type = Type::IN;
+
+            tasks[id].predecessors.push_back(pred);
+            link(id, tasks[id].predecessors.back(), &dep_id);
+
+            ++ndeps;
+            dep_r = std::max(dep_r, id - nd.parent);
+        }
+
+        std::vector<nnode_t> kids;
+
+        switch (shape) {
+            case FIB:
+                /* fib(k) spawns fib(k - 1) and fib(k - 2), leaves compute
+                 * theirs serially, i.e. in about fib(k + 1) calls */
+                if (nd.size >= std::max(cutoff, (uint32_t)2)) {
+                    for (uint32_t k = 1; k <= 2; k++) {
+                        nnode_t c = nd;
+
+                        c.parent = id;
+                        c.size   = nd.size - k;
+
+                        kids.push_back(c);
+                    }
+
+                    w.push_back(1);
+                } else {
+                    double a = 0, b = 1;
+
+                    for (uint32_t k = 0; k <= nd.size; k++) {
+                        double s = a + b;
+
+                        a = b;
+                        b = s;
+                    }
+
+                    w.push_back(a);
+                }
+                break;
+
+            case QSORT:
+                /* Partitioning around a random pivot, leaves sort theirs
+                 * serially */
+                if (nd.size > std::max(cutoff, (uint32_t)1)) {
+                    uint32_t r = gen() % nd.size;   // rank of the pivot
+                    nnode_t  c = nd;
+
+                    c.parent = id;
+
+                    if (r > 0) {
+                        c.size = r;
+                        kids.push_back(c);
+                    }
+
+                    if (nd.size - 1 - r > 0) {
+                        c.size = nd.size - 1 - r;
+                        kids.push_back(c);
+                    }
+
+                    w.push_back(nd.size);
+                } else {
+                    w.push_back(std::max(nd.size * log2(nd.size), 1.0));
+                }
+                break;
+
+            case BHTREE:
+                /* Cubes with too many bodies sort them into their octants,
+                 * leaves compute the forces on theirs by walking the tree */
+                if (nd.size > std::max(cutoff, (uint32_t)1) &&
+                    nd.depth < BH_MAX_DEPTH) {
+                    point* b = &body[nd.from];
+
+                    std::sort(b, b + nd.size, [&](const point& x, const point& y) {
+                        return octant(x, nd.c) < octant(y, nd.c);
+                    });
+
+                    for (uint32_t i = 0, o = 0; o < 8; o++) {
+                        nnode_t c = nd;
+
+                        c.parent = id;
+                        c.from   = nd.from + i;
+                        c.depth  = nd.depth + 1;
+                        c.h      = nd.h / 2;
+
+                        for (int d = 0; d < 3; d++) {
+                            c.c[d] = nd.c[d] + ((o >> d) & 1 ? c.h : -c.h);
+                        }
+
+                        while (i < nd.size && octant(b[i], nd.c) == o) {
+                            ++i;
+                        }
+
+                        c.size = nd.from + i - c.from;
+
+                        // Empty octants are not spawned
+                        if (c.size > 0) {
+                            kids.push_back(c);
+                        }
+                    }
+
+                    w.push_back(nd.size);
+                } else {
+                    w.push_back(std::max(nd.size * log2(n), 1.0));
+                }
+                break;
+
+            default:
+                w.push_back(1);
+                break;
+        }
+
+        tasks[id].wait = wait && !kids.empty();
+
+        // Children are pushed backwards, so that the first is taken first
+        stack.insert(stack.end(), kids.rbegin(), kids.rend());
+    }
+
+    ntasks = tasks.size();
+    nvar   = ndeps;
+
+    /* -- Durations follow the work of each task, normalized to a mean of
+     * the standard execution size */
+    double sum = 0;
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        sum += w[i];
+    }
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        // exec is kept as the offset from standard execution size
+        tasks[i].exec = w[i] * ntasks / sum - 1;
+    }
+
+    return true;
+}
+
+bool TaskGraph::nested() {
+    for (uint32_t i = 0; i < ntasks; i++) {
+        if (tasks[i].parent != (uint32_t)NONE) {
+            return true;
+        }
+    }
+
+    return false;
+}
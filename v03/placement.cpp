@@ -0,0 +1,350 @@
+/**
+ * Placement.cpp
+ *   Where the threads of a run execute and where the memory of its variables
+ *   lives, i.e. thread affinity and NUMA placement, and where they ended up
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <cerrno>
+#include <mutex>
+#include <tuple>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+/* ************************
+ * Machine topology
+ * ************************ */
+/* First integer of a sysfs file, or NONE */
+static int sys_int(const std::string& path) {
+    std::ifstream ifs(path);
+    int           v;
+
+    return ifs >> v ? v : NONE;
+}
+
+bool cpu_list(const char* s, std::vector<int>& cpus) {
+    cpus.clear();
+
+    while (*s != '\0' && *s != '\n') {
+        char* e;
+        long  lo = strtol(s, &e, 10), hi = lo;
+
+        if (e == s || lo < 0) {
+            return false;
+        }
+
+        if (*e == '-') {
+            s  = e + 1;
+            hi = strtol(s, &e, 10);
+
+            if (e == s || hi < lo) {
+                return false;
+            }
+        }
+
+        for (long c = lo; c <= hi; c++) {
+            cpus.push_back(c);
+        }
+
+        if (*e == ',') {
+            ++e;
+        } else if (*e != '\0' && *e != '\n') {
+            return false;
+        }
+
+        s = e;
+    }
+
+    return !cpus.empty();
+}
+
+std::vector<int> numa_nodes() {
+    std::ifstream    ifs("/sys/devices/system/node/online");
+    std::string      line;
+    std::vector<int> nodes;
+
+    if (!std::getline(ifs, line) || !cpu_list(line.c_str(), nodes)) {
+        nodes.assign(1, 0);
+    }
+
+    return nodes;
+}
+
+/* NUMA node of a CPU (0 if unknown) */
+static int node_of(const int cpu) {
+    std::vector<int> nodes = numa_nodes();
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        std::ifstream    ifs("/sys/devices/system/node/node" +
+                             std::to_string(nodes[i]) + "/cpulist");
+        std::string      line;
+        std::vector<int> cpus;
+
+        if (std::getline(ifs, line) && cpu_list(line.c_str(), cpus) &&
+            std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+            return nodes[i];
+        }
+    }
+
+    return 0;
+}
+
+/* ************************
+ * Thread placement state
+ * ************************ */
+static cpu_set_t                   p_all;           // CPUs of the process
+static bool                        p_init = false;  // whether p_all is known
+static std::mutex                  p_lock;          // guards p_init
+static std::atomic<bool>           p_pin(false);    // whether threads may be
+                                                    // pinned by an earlier run
+static std::atomic<uint64_t>       p_gen(0);        // last region placed
+
+static thread_local uint64_t       p_mine = (uint64_t)-1;   // region the
+                                                            // thread follows
+
+/* CPUs the process may run on, packed on neighbouring cores (siblings first)
+ * or spread over packages first and then over cores, siblings last */
+static std::vector<int> cpu_order(const uint8_t affinity) {
+    typedef struct { int cpu, pkg, core, sib; } cinfo;
+
+    std::vector<cinfo>                 info;
+    std::map<std::pair<int, int>, int> seen;    // CPUs so far of each core
+
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &p_all)) {
+            continue;
+        }
+
+        std::string top = "/sys/devices/system/cpu/cpu" + std::to_string(c) +
+                          "/topology/";
+        cinfo       i   = { c, sys_int(top + "physical_package_id"),
+                            sys_int(top + "core_id"), 0 };
+
+        i.sib = seen[std::make_pair(i.pkg, i.core)]++;
+
+        info.push_back(i);
+    }
+
+    std::stable_sort(info.begin(), info.end(), [&](const cinfo& a,
+                                                   const cinfo& b) {
+        if (affinity == Affinity::COMPACT) {
+            return std::make_tuple(a.pkg, a.core, a.sib) <
+                   std::make_tuple(b.pkg, b.core, b.sib);
+        }
+
+        return std::make_tuple(a.sib, a.core, a.pkg) <
+               std::make_tuple(b.sib, b.core, b.pkg);
+    });
+
+    std::vector<int> order;
+
+    for (size_t i = 0; i < info.size(); i++) {
+        order.push_back(info[i].cpu);
+    }
+
+    return order;
+}
+
+/* ************************
+ * Memory placement
+ * ************************ */
+static long set_policy(void* addr, const uint64_t len, const int mode,
+                       const std::vector<int>& nodes) {
+    unsigned long mask[16] = { 0 };     // up to 1024 nodes
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i] < 1024) {
+            mask[nodes[i] / 64] |= 1ul << (nodes[i] % 64);
+        }
+    }
+
+    return syscall(SYS_mbind, addr, len, mode, mode == MPOL_DEFAULT ? NULL : mask,
+                   mode == MPOL_DEFAULT ? 0 : 1024, mode == MPOL_DEFAULT ? 0 :
+                   MPOL_MF_MOVE);
+}
+
+/* ************************
+ * Placement of a run
+ * ************************ */
+void TaskLab::place_start(rplace_t* pc, const tenant_t* tn) {
+    {
+        std::lock_guard<std::mutex> l(p_lock);
+
+        if (!p_init) {
+            sched_getaffinity(0, sizeof(p_all), &p_all);
+
+            p_init = true;
+        }
+    }
+
+    switch (tn->cfg.affinity) {
+        case COMPACT:
+        case SPREAD:
+            pc->cpu = cpu_order(tn->cfg.affinity);
+            break;
+
+        case CPUS:
+            cpu_list(tn->cfg.cpus.c_str(), pc->cpu);
+            break;
+
+        default:
+            pc->cpu.clear();
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> l(pc->lock);
+
+        pc->thr.clear();
+    }
+
+    pc->id = ++p_gen;
+
+    // The dispatching thread goes on the first CPU
+    place(pc, 0);
+
+    /* -- Variables of the plan */
+    long r = 0;
+
+    switch (tn->cfg.placement) {
+        case TOUCH:
+            // Dropped pages come back on the node of whoever touches them
+            r = set_policy(tn->pl->varmap, tn->pl->varmap_s, MPOL_DEFAULT,
+                           std::vector<int>());
+
+            if (r == 0) {
+                r = madvise(tn->pl->varmap, tn->pl->varmap_s, MADV_DONTNEED);
+            }
+            break;
+
+        case INTERLEAVE:
+            r = set_policy(tn->pl->varmap, tn->pl->varmap_s, MPOL_INTERLEAVE,
+                           numa_nodes());
+            break;
+
+        case BIND:
+            r = set_policy(tn->pl->varmap, tn->pl->varmap_s, MPOL_BIND,
+                           std::vector<int>(1, tn->cfg.node));
+            break;
+
+        default:
+            break;
+    }
+
+    if (r != 0) {
+        fprintf(stderr, "[ERROR] Couldn't place variables (%s).\n",
+                strerror(errno));
+    }
+}
+
+void TaskLab::place(rplace_t* pc, kmp_int32 gtid) {
+    // Threads serving several regions follow the last one they served
+    if (p_mine == pc->id) {
+        return;
+    }
+
+    p_mine = pc->id;
+
+    tplace_t tp = { NONE, NONE };
+
+    if (!pc->cpu.empty()) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(pc->cpu[gtid % pc->cpu.size()], &set);
+
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+            tp.cpu = pc->cpu[gtid % pc->cpu.size()];
+            p_pin  = true;
+        } else {
+            fprintf(stderr, "[ERROR] Couldn't pin thread %d on CPU %d (%s).\n",
+                    gtid, pc->cpu[gtid % pc->cpu.size()], strerror(errno));
+        }
+    } else if (p_pin) {
+        // Free threads pinned by an earlier run
+        sched_setaffinity(0, sizeof(p_all), &p_all);
+    }
+
+    tp.ran = sched_getcpu();
+
+    std::lock_guard<std::mutex> l(pc->lock);
+
+    pc->thr[gtid] = tp;
+}
+
+void TaskLab::place_report(rplace_t* pc, const tenant_t& tn) {
+    const plan_t* pl  = tn.pl;
+    const rcfg&   cfg = tn.cfg;
+
+    const char* aff[] = { "", "free", "compact", "spread", "cpu list" };
+    const char* plc[] = { "", "left", "first touch", "interleaved", "bound" };
+
+    printf("--- Placement\n");
+    printf("\tThreads (%s):\n", aff[cfg.affinity]);
+
+    {
+        std::lock_guard<std::mutex> l(pc->lock);
+
+        std::map<int32_t, tplace_t>::iterator it;
+        for (it = pc->thr.begin(); it != pc->thr.end(); ++it) {
+            if (it->second.cpu == NONE) {
+                printf("\t\tthread %-4d not pinned, on CPU %d (node %d)\n",
+                       it->first, it->second.ran, node_of(it->second.ran));
+            } else {
+                printf("\t\tthread %-4d CPU %d (node %d), on CPU %d\n",
+                       it->first, it->second.cpu, node_of(it->second.cpu),
+                       it->second.ran);
+            }
+        }
+    }
+
+    /* -- Node of a sample of the pages holding variables */
+    long                page = sysconf(_SC_PAGESIZE);
+    uint32_t            nvar = pl->vaddr.size();
+    uint32_t            step = std::max(nvar / MAX_PLACE_PAGES, (uint32_t)1);
+    std::vector<void*>  pages;
+
+    for (uint32_t v = 0; v < nvar; v += step) {
+        void* p = (void*)(pl->vaddr[v] & ~(kmp_intptr)(page - 1));
+
+        if (pages.empty() || pages.back() != p) {
+            pages.push_back(p);
+        }
+    }
+
+    std::vector<int>        status(pages.size(), 0);
+    std::map<int, uint64_t> by_node;
+
+    if (!pages.empty() &&
+        syscall(SYS_move_pages, 0, pages.size(), pages.data(), NULL,
+                status.data(), 0) != 0) {
+        fprintf(stderr, "[ERROR] Couldn't locate variable pages (%s).\n",
+                strerror(errno));
+
+        return;
+    }
+
+    for (size_t i = 0; i < status.size(); i++) {
+        ++by_node[status[i] < 0 ? NONE : status[i]];
+    }
+
+    printf("\tVariables (%s), %zu pages located:\n", plc[cfg.placement],
+           pages.size());
+
+    std::map<int, uint64_t>::iterator it;
+    for (it = by_node.begin(); it != by_node.end(); ++it) {
+        if (it->first == NONE) {
+            printf("\t\tnot in memory %10llu (%.1f%%)\n",
+                   (unsigned long long)it->second, 100.0 * it->second / pages.size());
+        } else {
+            printf("\t\tnode %-8d %10llu (%.1f%%)\n", it->first,
+                   (unsigned long long)it->second, 100.0 * it->second / pages.size());
+        }
+    }
+}
@@ -0,0 +1,365 @@
+/**
+ * Profiler.cpp
+ *   Extraction of task graph statistics and synthesis of look-alike graphs
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <set>
+
+/* ************************
+ * Sampling helpers
+ * ************************ */
+/**
+ * Cumulative distribution of a histogram, in order to draw its values
+ */
+class Cdf {
+public:
+    template<typename It>
+    void add(const uint32_t value, It count) {
+        if (count > 0) {
+            val.push_back(value);
+            cum.push_back((cum.empty() ? 0 : cum.back()) + count);
+        }
+    }
+
+    bool empty() const {
+        return cum.empty();
+    }
+
+    uint32_t draw(std::mt19937& gen) const {
+        std::uniform_real_distribution<double> u(0, cum.back());
+
+        size_t i = std::upper_bound(cum.begin(), cum.end(), u(gen))
+                   - cum.begin();
+
+        return val[std::min(i, val.size() - 1)];
+    }
+
+private:
+    std::vector<uint32_t> val;
+    std::vector<double>   cum;
+};
+
+/* ************************
+ * Profile
+ * ************************ */
+void profile_s::summary(FILE* fd, const char* title) const {
+    double   in = 0, out = 0, d = 0, ne = 0, nd = 0;
+    uint32_t wmax = 0;
+
+    for (size_t i = 0; i < indeg.size(); i++) {
+        in += (double)i * indeg[i];
+    }
+
+    for (size_t i = 0; i < outdeg.size(); i++) {
+        out += (double)i * outdeg[i];
+    }
+
+    std::map<uint32_t, uint64_t>::const_iterator it;
+    for (it = dist.begin(); it != dist.end(); ++it) {
+        d  += (double)it->first * it->second;
+        nd += it->second;
+    }
+
+    for (size_t i = 0; i < mix.size(); i++) {
+        ne += mix[i];
+    }
+
+    for (size_t i = 0; i < width.size(); i++) {
+        wmax = std::max(wmax, width[i]);
+    }
+
+    fprintf(fd, "--- %s\n", title);
+    fprintf(fd, "\tTasks:                   %u\n", ntasks);
+    fprintf(fd, "\tLevels (span):           %zu\n", width.size());
+    fprintf(fd, "\tAvg./max. level width:   %.2f / %u\n",
+            width.empty() ? 0 : (double)ntasks / width.size(), wmax);
+    fprintf(fd, "\tAvg. in/out degree:      %.2f / %.2f\n",
+            ntasks ? in / ntasks : 0, ntasks ? out / ntasks : 0);
+    fprintf(fd, "\tAvg. predecessor dist.:  %.2f\n", nd ? d / nd : 0);
+    fprintf(fd, "\tIN/INOUT/OUT edges:      %.1f%% / %.1f%% / %.1f%%\n",
+            ne ? 100 * mix[Type::IN] / ne : 0,
+            ne ? 100 * mix[Type::INOUT] / ne : 0,
+            ne ? 100 * mix[Type::OUT] / ne : 0);
+}
+
+/* ************************
+ * Task graph profiling
+ * ************************ */
+void TaskGraph::profile(gprofile& p) {
+    std::vector<uint32_t> level(ntasks, 0);
+    std::vector<uint32_t> children(ntasks, 0);
+    float                 dmin = -1, dmax = 0;
+
+    p.ntasks = ntasks;
+    p.exec_t = exec_t;
+
+    p.indeg.assign(1, 0);
+    p.outdeg.assign(1, 0);
+    p.dist.clear();
+    p.mix.assign(4, 0);
+    p.width.clear();
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        std::set<uint32_t> parents;   // a parent may be reached by many vars
+
+        std::list<_dep>::iterator it;
+        for (it = tasks[i].predecessors.begin();
+             it != tasks[i].predecessors.end(); ++it) {
+            if (it->type < p.mix.size()) {
+                ++p.mix[it->type];
+            }
+
+            if (!parents.insert(it->task).second) {
+                continue;
+            }
+
+            // Tasks only rely on previous ones
+            level[i] = std::max(level[i], level[it->task] + 1);
+
+            ++children[it->task];
+            ++p.dist[i - it->task];
+        }
+
+        if (parents.size() >= p.indeg.size()) {
+            p.indeg.resize(parents.size() + 1, 0);
+        }
+        ++p.indeg[parents.size()];
+
+        if (level[i] >= p.width.size()) {
+            p.width.resize(level[i] + 1, 0);
+        }
+        ++p.width[level[i]];
+
+        float m = tasks[i].exec + 1;
+        if (m > 0 && (dmin < 0 || m < dmin)) {
+            dmin = m;
+        }
+        dmax = std::max(dmax, m);
+    }
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        if (children[i] >= p.outdeg.size()) {
+            p.outdeg.resize(children[i] + 1, 0);
+        }
+        ++p.outdeg[children[i]];
+    }
+
+    /* -- Histogram of durations, with log-spaced bins so that long tails
+     * are kept */
+    p.dlo.clear();
+    p.dhi.clear();
+    p.dw.assign(PROFILE_BINS + 1, 0);
+
+    if (dmin < 0 || dmax <= dmin) {
+        // Every task lasts the same
+        p.dlo.push_back(std::max(dmax, 0.0f));
+        p.dhi.push_back(std::max(dmax, 0.0f));
+        p.dw.assign(1, ntasks);
+
+        return;
+    }
+
+    float step = log(dmax / dmin) / PROFILE_BINS;
+
+    // First bin holds tasks with no load at all
+    p.dlo.push_back(0);
+    p.dhi.push_back(0);
+
+    for (uint32_t b = 0; b < PROFILE_BINS; b++) {
+        p.dlo.push_back(dmin * exp(step * b));
+        p.dhi.push_back(dmin * exp(step * (b + 1)));
+    }
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        float m = tasks[i].exec + 1;
+
+        if (m <= 0) {
+            ++p.dw[0];
+        } else {
+            uint32_t b = log(m / dmin) / step;
+
+            ++p.dw[std::min(b, (uint32_t)PROFILE_BINS - 1) + 1];
+        }
+    }
+}
+
+/* ************************
+ * Task graph synthesis
+ * ************************ */
+void TaskGraph::synthesize(const gprofile& p, const bool keep_span) {
+    std::mt19937 gen(rand());
+    Cdf          indeg, outdeg, dist, mix;
+
+    for (size_t i = 0; i < p.indeg.size(); i++) {
+        indeg.add(i, p.indeg[i]);
+    }
+
+    for (size_t i = 0; i < p.outdeg.size(); i++) {
+        outdeg.add(i, p.outdeg[i]);
+    }
+
+    std::map<uint32_t, uint64_t>::const_iterator d;
+    for (d = p.dist.begin(); d != p.dist.end(); ++d) {
+        dist.add(d->first, d->second);
+    }
+
+    for (size_t i = 0; i < p.mix.size(); i++) {
+        mix.add(i, p.mix[i]);
+    }
+
+    /* -- Bounds of each level, stretching the profiled widths */
+    uint32_t              src_l = std::max((size_t)1, p.width.size());
+    uint32_t              nlvl;
+    std::vector<double>   cum(1, 0);
+    std::vector<uint32_t> bound;
+
+    if (keep_span || p.ntasks == 0) {
+        nlvl = src_l;
+    } else {
+        nlvl = std::max(1.0, round((double)src_l * ntasks / p.ntasks));
+    }
+
+    nlvl = std::min(nlvl, std::max(ntasks, (uint32_t)1));
+
+    for (uint32_t l = 0; l < nlvl; l++) {
+        uint32_t s = (uint64_t)l * src_l / nlvl;
+
+        cum.push_back(cum.back() + (s < p.width.size() ? p.width[s] : 1));
+    }
+
+    // Every level gets at least one task
+    for (uint32_t l = 0; l <= nlvl; l++) {
+        uint32_t b = round(ntasks * cum[l] / cum.back());
+
+        if (l > 0) {
+            b = std::max(b, bound.back() + 1);
+        }
+
+        bound.push_back(std::min(b, ntasks));
+    }
+
+    /* -- Create tasks level by level, in ID order */
+    std::vector<uint32_t> children(ntasks, 0);
+    std::vector<uint32_t> target(ntasks, 0);   // desired no. of children
+    uint32_t              dep_id = 0;
+    uint32_t              start  = 0;          // first task of current level
+    uint32_t              prev   = 0;          // first task of previous level
+    uint32_t              rr     = 0;          // round robin on previous level
+    uint32_t              window = p.dist.empty() ? DEFAULT_DEP_RANGE
+                                                  : p.dist.rbegin()->first;
+
+    dep_r = 0;
+
+    for (uint32_t l = 0; l < nlvl && start < ntasks; l++) {
+        uint32_t end = l == nlvl - 1 ? ntasks : bound[l + 1];
+
+        for (uint32_t i = start; i < end; i++) {
+            std::set<uint32_t> picked;
+
+            tasks[i].tID = i;
+            target[i]    = outdeg.empty() ? 0 : outdeg.draw(gen);
+
+            if (l == 0) {
+                continue;
+            }
+
+            // Tasks beyond the first level need a parent on the previous one
+            uint32_t k = indeg.empty() ? 1 : indeg.draw(gen);
+            k = std::min(std::max(k, (uint32_t)1), start);
+
+            for (uint32_t j = 0; j < k; j++) {
+                uint32_t lo   = j == 0 ? prev : 0;
+                uint32_t cand = (uint32_t)NONE;
+
+                // Draw a distance, preferring parents still short of children
+                for (int a = 0; a < 8 && !dist.empty(); a++) {
+                    uint32_t dd = dist.draw(gen);
+
+                    // Distances landing on the current level are taken
+                    // from its first task instead
+                    uint32_t c = i - dd >= start ? start - dd : i - dd;
+
+                    if (dd > start || c < lo || picked.count(c)) {
+                        continue;
+                    }
+
+                    cand = c;
+
+                    if (a >= 4 || children[cand] < target[cand]) {
+                        break;
+                    }
+                }
+
+                if (cand == (uint32_t)NONE) {
+                    if (j == 0) {
+                        // Cycle over the previous level
+                        cand = prev + rr++ % (start - prev);
+                    } else {
+                        cand = start - 1 - rand() % std::min(start, window);
+                    }
+
+                    if (picked.count(cand)) {
+                        continue;
+                    }
+                }
+
+                picked.insert(cand);
+
+                _dep pred;
+                pred.task = cand;
+                pred.type = mix.empty() ? (uint8_t)Type::IN : mix.draw(gen);
+
+                if (pred.type != Type::IN && pred.type != Type::OUT) {
+                    pred.type = Type::INOUT;
+                }
+
+                tasks[i].predecessors.push_back(pred);
+                link(i, tasks[i].predecessors.back(), &dep_id);
+
+                ++children[cand];
+                dep_r = std::max(dep_r, i - cand);
+            }
+
+            ndeps += tasks[i].predecessors.size();
+        }
+
+        prev  = start;
+        start = end;
+        rr    = 0;
+    }
+
+    nvar   = ndeps;
+    exec_t = p.exec_t;
+
+    /* -- Durations from the profiled histogram */
+    dur.dist = Dist::EMPIRICAL;
+    dur.lo   = p.dlo;
+    dur.hi   = p.dhi;
+    dur.w.clear();
+
+    double tw = 0, mean = 0;
+    for (size_t b = 0; b < p.dw.size(); b++) {
+        tw   += p.dw[b];
+        mean += p.dw[b] * (p.dlo[b] + p.dhi[b]) / 2;
+        dur.w.push_back(tw);
+    }
+
+    // Keep the profiled mean, folding it into the standard execution size
+    if (tw > 0 && mean > 0) {
+        mean /= tw;
+        exec_t = exec_t * mean;
+
+        for (size_t b = 0; b < dur.lo.size(); b++) {
+            dur.lo[b] /= mean;
+            dur.hi[b] /= mean;
+        }
+    } else {
+        dur.dist = Dist::UNIFORM;
+    }
+
+    assign_durations();
+}
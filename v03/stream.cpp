@@ -0,0 +1,391 @@
+/**
+ * Stream.cpp
+ *   Generation and dispatch of task graphs larger than memory: tasks are
+ *   written to and read from a .sdat file in ID order, and only a window of
+ *   them is ever kept.
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <deque>
+#include <atomic>
+
+/* ************************
+ * Streamed generation
+ * ************************ */
+bool TaskLab::stream(const char* filename, const uint32_t n, const uint32_t m,
+                     const uint32_t d, const uint32_t t, const float r) {
+    /* Predecessors are written as their distance, which can't be 0 */
+    if (d == 0) {
+        fprintf(stderr, "[ERROR] A predecessor has to be at least 1 task away. \
+Couldn't stream task graph.\n");
+
+        return false;
+    }
+
+    const char* filename_ = add_extension(filename, ".sdat");
+
+    std::ofstream ofs(filename_, std::ofstream::binary);
+
+    delete[] filename_;
+
+    if (!ofs.is_open()) {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't stream task graph.\n");
+
+        return false;
+    }
+
+    shead h = { STREAM_MAGIC, n, 0, d, 0, t, r };
+
+    // Header is written again once the no. of dependencies is known
+    ofs.write((char*)&h, sizeof(h));
+
+    /* Seed random generator */
+    srand(time(NULL));
+
+    std::mt19937          gen(rand());
+    dmodel                dur   = dm;
+    std::vector<uint32_t> depth(d + 1, 0);    // depth of the last d tasks
+    std::vector<uint32_t> results;
+    double                sum   = 0;          // running sum of correlated prop.
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t range_min, range_max;
+        uint32_t npred = 0;
+        uint32_t dp    = 0;
+
+        results.clear();
+
+        // Same ranges as create_tasks, the first task has no predecessors
+        if (i > 0) {
+            uint32_t cur_dep = i <= m ? i - 1 : m;
+
+            range_min = i < d ? 0 : i - d;
+            range_max = range_min + d >= i ? i : range_min + d;
+
+            cur_dep = std::min(cur_dep, range_max - range_min);
+            npred   = cur_dep == 0 ? 1 : rand() % cur_dep + 1;
+
+            for (uint32_t j = 0; j < npred; j++) {
+                uint32_t p;
+
+                // Define a task that hasn't been picked yet
+                do {
+                    p = range_max != range_min ?
+                        range_min + (rand() % (range_max - range_min)) :
+                        range_min;
+                } while (std::find(results.begin(), results.end(), p)
+                         != results.end());
+
+                results.push_back(p);
+
+                dp = std::max(dp, depth[p % (d + 1)] + 1);
+            }
+        }
+
+        depth[i % (d + 1)] = dp;
+
+        /* Load time, correlated against the running mean of the property */
+        float m_ = dur.sample(gen, r);
+        float pr = dur.corr == Corr::NDEPS ? npred :
+                   dur.corr == Corr::DEPTH ? dp : 1;
+
+        sum += pr;
+
+        if (dur.corr != Corr::FLAT && sum > 0) {
+            m_ *= (1 - dur.weight) + dur.weight * pr * (i + 1) / sum;
+        }
+
+        float exec = m_ - 1;
+
+        ofs.write((char*)&exec, sizeof(exec));
+        ofs.write((char*)&npred, sizeof(npred));
+
+        for (uint32_t j = 0; j < npred; j++) {
+            uint32_t dist = i - results[j];
+
+            // Set a random type for the dependency, either IN or INOUT
+            uint8_t  type = Type(rand() % 2) == 0 ? 1 : 3;
+
+            ofs.write((char*)&dist, sizeof(dist));
+            ofs.write((char*)&type, sizeof(type));
+        }
+
+        h.ndeps  += npred;
+        h.max_dep = std::max(h.max_dep, npred);
+    }
+
+    ofs.seekp(0);
+    ofs.write((char*)&h, sizeof(h));
+
+    if (!ofs.good()) {
+        fprintf(stderr, "[ERROR] Couldn't write streamed task graph.\n");
+
+        return false;
+    }
+
+    return true;
+}
+
+/* ************************
+ * Streamed dispatch
+ * ************************ */
+bool TaskLab::run(const char* filename, const uint8_t rt,
+                  const uint32_t window) {
+    const char* filename_ = add_extension(filename, ".sdat");
+
+    std::ifstream ifs(filename_, std::ifstream::binary);
+
+    delete[] filename_;
+
+    if (!ifs.is_open()) {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't open streamed task graph.\n");
+
+        return false;
+    }
+
+    sstate_t ss;    // the stream, as read by its dispatcher
+
+    ifs.read((char*)&ss.h, sizeof(ss.h));
+
+    if (!ifs.good() || ss.h.magic != STREAM_MAGIC) {
+        fprintf(stderr, "[ERROR] Invalid streamed task graph.\n");
+
+        return false;
+    }
+
+    /* Initialize runtime functions based on the runtime */
+    if (!init_run(rt)) {
+        /* Uh oh! Something went wrong! */
+        return false;
+    }
+
+    // The dispatcher waits for window slots, freed by the other threads
+    if (team_size() < 2) {
+        fprintf(stderr, "[ERROR] Streamed graphs need a thread besides the \
+dispatcher.\n");
+
+        return false;
+    }
+
+    /* Tasks only need the execution sizes of the graph */
+    TaskGraph hdr(0, ss.h.dep_r, ss.h.exec_t, ss.h.max_r);
+
+    region_t rg;                    // parallel region of the run
+    tenant_t tn(&hdr, NULL, cfg);   // and its only graph
+
+    ss.in   = &ifs;
+    ss.w    = std::max(window, (uint32_t)1);
+    ss.free = NULL;
+
+    rg.tn.assign(1, &tn);
+    rg.mix = Mix::PER_PRODUCER;
+    tn.ss  = &ss;
+    tn.pc  = &rg.pc;
+
+    if (rt == RT::MTSP) {
+        // Start execution of a parallel region
+        fork_call(NULL, 1, (kmpc_micro) stream_microtask, &rg);
+    }
+
+    /* Was the execution successful? */
+    if (tn.error) {
+        printf("[ERROR] The graph did not executed correctly!\n");
+
+        return false;
+    } else {
+        /* Everything went fine! */
+        return true;
+    }
+}
+
+void TaskLab::stream_microtask(int gid, int tid, void* param) {
+    region_t* rg = (region_t*) param;
+    tenant_t* tn = rg->tn[0];
+    sstate_t* ss = tn->ss;
+
+    /* When task i is dispatched, every task up to i - w is done and at most
+     * dep_r tasks were read ahead, so only dependencies of the last
+     * w + dep_r + 1 tasks are alive */
+    uint64_t   n_d     = (uint64_t)(ss->w + ss->h.dep_r + 1) *
+                         std::max(ss->h.max_dep, (uint32_t)1);
+
+    bool*      dep_chk = new bool[n_d];   /* Dependency validation ring */
+    bool*      varptr  = new bool[n_d];   /* Variables addresses ring */
+    tparam_t*  params  = new tparam_t[ss->w];
+
+    std::vector< std::vector<bool*> > pred(ss->w);
+    std::vector< std::vector<bool*> > succ(ss->w);
+
+    ss->free = new std::atomic<bool>[ss->w];
+
+    for (uint32_t i = 0; i < ss->w; i++) {
+        ss->free[i] = true;
+    }
+
+    memset(varptr, false, n_d * sizeof(bool));
+
+    std::vector<kmp_depend_info> dep_list(ss->h.max_dep * 2 + 2);
+
+    std::deque<_task> ahead;           // tasks read but not dispatched yet
+    uint32_t          next   = 0;      // next task to be read
+    uint64_t          dep_id = 0;      // next dependency to be read
+    bool              valid  = true;   // whether the file is consistent
+
+    std::cout << "Start Dispatching tasks!\n";
+
+    for (uint32_t cur_task = 0; cur_task < ss->h.ntasks; cur_task++) {
+        /* -- Read ahead, so that every child of the task is known */
+        for (; valid && next < ss->h.ntasks && next <= cur_task + ss->h.dep_r;
+             next++) {
+            _task    t;
+            uint32_t npred;
+
+            ss->in->read((char*)&t.exec, sizeof(t.exec));
+            ss->in->read((char*)&npred, sizeof(npred));
+
+            // A truncated file, or more predecessors than the ring holds
+            if (!ss->in->good() || npred > ss->h.max_dep) {
+                fprintf(stderr, "[ERROR] Corrupted streamed task graph at task %u.\n",
+                        next);
+
+                tn->error = true;
+                valid     = false;
+                break;
+            }
+
+            t.tID   = next;
+            t.npred = npred;
+
+            ahead.push_back(t);
+
+            for (uint32_t j = 0; valid && j < npred; j++) {
+                uint32_t dist;
+                uint8_t  type;
+
+                ss->in->read((char*)&dist, sizeof(dist));
+                ss->in->read((char*)&type, sizeof(type));
+
+                if (!ss->in->good() || dist == 0 || dist > next ||
+                    next - dist < cur_task) {
+                    fprintf(stderr, "[ERROR] Corrupted streamed task graph at task %u.\n",
+                            next);
+
+                    tn->error = true;
+                    valid     = false;
+                    break;
+                }
+
+                // Dependencies are identified by their slot on the ring
+                uint32_t slot = dep_id++ % n_d;
+                _dep     p    = { next - dist, type, slot, slot };
+                _dep     c    = { 0, type, slot, slot };
+                _dep     b    = { next, Type::OUT, slot, slot };
+
+                dep_chk[slot] = false;
+
+                ahead.back().predecessors.push_back(p);
+                ahead.back().successors.push_back(c);
+                ahead[next - dist - cur_task].successors.push_back(b);
+            }
+        }
+
+        if (!valid) {
+            break;
+        }
+
+        /* -- Wait for the slot of the task on the window */
+        uint32_t slot = cur_task % ss->w;
+
+        while (!ss->free[slot].load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        ss->free[slot].store(false, std::memory_order_relaxed);
+
+        _task&          t = ahead.front();
+        tparam_t&       p = params[slot];
+
+        dep_list.resize(std::max(dep_list.size(), t.successors.size() + 1));
+
+        kmp_task* task = (kmp_task*)omp_task_alloc(NULL, 0, 0,
+                                                   sizeof(kmp_task) + sizeof(tpriv_t), 0,
+                                                   (kmp_routine_entry)stask_f);
+        tpriv_t*  v    = (tpriv_t*)(task + 1);
+
+        v->tn = tn;
+        v->it = 0;
+
+        pred[slot].clear();
+        succ[slot].clear();
+
+        p.tID    = cur_task;
+        p.exec   = t.exec;
+        p.pred_s = t.predecessors.size();
+        p.succ_s = t.successors.size();
+        p.kern   = kernel_of(tn->cfg.kernel, cur_task);
+        p.rd_s   = 0;       // streamed variables carry no payload
+        p.wr_s   = 0;
+
+        /* Set first position which will be used as pointer ref. */
+        dep_list[0].base_addr = (kmp_intptr) &p;
+        dep_list[0].len       = sizeof(p);
+        dep_list[0].flags.in  = true;
+        dep_list[0].flags.out = false;
+
+        uint32_t i = 1;
+
+        std::list<_dep>::iterator it;
+        for (it = t.successors.begin(); it != t.successors.end(); ++it, ++i) {
+            dep_list[i].base_addr = (kmp_intptr) &varptr[it->var];
+            dep_list[i].len       = sizeof(varptr[it->var]);
+            dep_list[i].flags.in  = (it->type != Type::OUT) ? true : false;
+            dep_list[i].flags.out = (it->type != Type::IN) ? true : false;
+
+            succ[slot].push_back(&dep_chk[it->dID]);
+        }
+
+        for (it = t.predecessors.begin(); it != t.predecessors.end(); ++it) {
+            pred[slot].push_back(&dep_chk[it->dID]);
+        }
+
+        p.pred = pred[slot].data();
+        p.succ = succ[slot].data();
+
+        omp_task_with_deps(NULL, 0, task, i, dep_list.data(), 0, NULL);
+
+        ahead.pop_front();
+    }
+
+    std::cout << "\tDone Dispatching!\n";
+
+    // Wait until all tasks have been executed
+    omp_taskwait(nullptr, 0);
+
+    std::cout << "\tDone executing!\n";
+
+    delete[] dep_chk;
+    delete[] varptr;
+    delete[] params;
+    delete[] ss->free;
+
+    ss->free = NULL;
+}
+
+void TaskLab::stask_f(kmp_int32 gtid, void* param) {
+    kmp_task* t = (kmp_task*) param;
+    mtsp_task_metadata* md = t->metadata;
+
+    /* --- get param! --- */
+    tparam_t* p = (tparam_t*) md->dep_list[0].base_addr;
+    tpriv_t*  v = (tpriv_t*)(t + 1);
+
+    f(v->tn, *p);
+
+    /* Free its slot on the window */
+    sstate_t* ss = v->tn->ss;
+
+    ss->free[p->tID % ss->w].store(true, std::memory_order_release);
+}
@@ -0,0 +1,322 @@
+/**
+ * Table.cpp
+ *   Software model of the dependency table and task queue of a hardware
+ *   runtime (e.g. TIOGA), fed by the dependency descriptors of a graph
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <queue>
+
+/* ***************
+ * Table configuration
+ * *************** */
+table_config::table_config() : sets(DEFAULT_SETS), ways(DEFAULT_WAYS),
+                               queue(DEFAULT_QUEUE), max_deps(DEFAULT_TDEPS),
+                               workers(std::max(std::thread::hardware_concurrency(),
+                                                1u)),
+                               c_task(DEFAULT_C_TASK), c_dep(DEFAULT_C_DEP),
+                               cpi(1) {};
+
+/* ************************
+ * Simulation
+ * ************************ */
+/**
+ * Discrete event simulation of a single producer feeding the table, and of
+ * workers running tasks as soon as they are ready
+ */
+class TableSim {
+public:
+    /* Outcome of a simulation (cycles) */
+    uint64_t time      = 0;     // when the last task finished
+    uint64_t s_queue   = 0;     // producer stalls on a full queue
+    uint64_t s_set     = 0;     // producer stalls on a full set
+    uint64_t s_limit   = 0;     // producer stalls on tasks over the limit
+    uint64_t inserts   = 0;     // addresses inserted on the table
+    uint64_t hits      = 0;     // addresses found on the table already
+    uint64_t conflicts = 0;     // insertions that found their set full
+    uint64_t over      = 0;     // tasks over the dependency limit
+    uint64_t occ_sum   = 0;     // entries in use, summed at every submission
+    uint64_t occ_max   = 0;
+    uint64_t q_sum     = 0;     // queue entries in use, likewise
+    uint64_t q_max     = 0;
+
+    TableSim(const tcfg& c, const uint32_t ntasks, kmp_depend_info** dep_list,
+             const uint32_t* dep_n, const std::vector<uint32_t>& pt,
+             const std::vector<uint32_t>& pt_off,
+             const std::vector<uint64_t>& dur) :
+        c(c), n(ntasks), dep_list(dep_list), dep_n(dep_n), dur(dur),
+        set(c.sets), left(ntasks), held(ntasks), child(ntasks),
+        submitted(ntasks, false) {
+        for (uint32_t t = 0; t < n; t++) {
+            left[t] = pt_off[t + 1] - pt_off[t];
+
+            for (uint32_t j = pt_off[t]; j < pt_off[t + 1]; j++) {
+                child[pt[j]].push_back(t);
+            }
+        }
+
+        free_w = std::max(c.workers, (uint32_t)1);
+    }
+
+    void run() {
+        uint64_t now = 0;     // producer clock
+
+        for (uint32_t t = 0; t < n; t++) {
+            uint32_t nd = dep_n[t] - 1;   // the first entry holds the params
+
+            complete(now);
+
+            // Tasks over the limit go once everything else is done
+            if (nd > c.max_deps) {
+                ++over;
+                stall(now, s_limit, [&]() { return inq == 0; });
+            }
+
+            stall(now, s_queue, [&]() { return inq < c.queue; });
+
+            q_sum += inq;
+            q_max  = std::max(q_max, (uint64_t)inq);
+
+            /* -- Insert every address on its set */
+            for (uint32_t i = 1; i <= nd && nd <= c.max_deps; i++) {
+                kmp_intptr a = dep_list[t][i].base_addr;
+                uint32_t   s = hash(a);
+                int        w = find(s, a);
+
+                if (w >= 0) {
+                    ++hits;
+                } else {
+                    ++inserts;
+
+                    if (set[s].size() >= c.ways) {
+                        ++conflicts;
+
+                        // Give up if the set is held by the task itself
+                        if (!stall(now, s_set, [&]() {
+                                return set[s].size() < c.ways;
+                            })) {
+                            continue;
+                        }
+                    }
+
+                    set[s].push_back({ a, 0 });
+                    w = set[s].size() - 1;
+                    ++used;
+                }
+
+                ++set[s][w].refs;
+                held[t].push_back(a);
+            }
+
+            occ_sum += used;
+            occ_max  = std::max(occ_max, used);
+
+            now += c.c_task + (uint64_t)c.c_dep * nd;
+
+            ++inq;
+            submitted[t] = true;
+
+            if (left[t] == 0) {
+                ready.push(t);
+            }
+
+            start(now);
+        }
+
+        // Drain whatever is still running
+        complete((uint64_t)-1);
+
+        time = std::max(time, now);
+    }
+
+private:
+    typedef struct { kmp_intptr addr; uint32_t refs; } entry;
+    typedef std::pair<uint64_t, uint32_t>              event;   // finish, task
+
+    const tcfg&                         c;
+    uint32_t                            n;
+    kmp_depend_info**                   dep_list;
+    const uint32_t*                     dep_n;
+    const std::vector<uint64_t>&        dur;
+
+    std::vector< std::vector<entry> >   set;
+    std::vector<uint32_t>               left;      // unfinished predecessors
+    std::vector< std::vector<kmp_intptr> > held;   // addresses of each task
+    std::vector< std::vector<uint32_t> > child;
+    std::vector<bool>                   submitted;
+    std::queue<uint32_t>                ready;
+    std::priority_queue<event, std::vector<event>,
+                        std::greater<event> > running;
+
+    uint32_t                            free_w;
+    uint32_t                            inq  = 0;  // tasks on the queue
+    uint64_t                            used = 0;  // entries in use
+
+    uint32_t hash(const kmp_intptr a) const {
+        uint64_t h = a;
+
+        // Fold upper bits, so that strided addresses spread over sets
+        h ^= h >> 7;
+        h ^= h >> 17;
+
+        return h % std::max(c.sets, (uint32_t)1);
+    }
+
+    int find(const uint32_t s, const kmp_intptr a) const {
+        for (size_t w = 0; w < set[s].size(); w++) {
+            if (set[s][w].addr == a) {
+                return w;
+            }
+        }
+
+        return -1;
+    }
+
+    /* Start ready tasks on free workers at time t */
+    void start(const uint64_t t) {
+        while (free_w > 0 && !ready.empty()) {
+            uint32_t k = ready.front();
+
+            ready.pop();
+            --free_w;
+
+            running.push(event(t + dur[k], k));
+        }
+    }
+
+    /* Finish every task done by time t */
+    void complete(const uint64_t t) {
+        while (!running.empty() && running.top().first <= t) {
+            event e = running.top();
+
+            running.pop();
+
+            time = std::max(time, e.first);
+
+            ++free_w;
+            --inq;
+
+            for (size_t i = 0; i < held[e.second].size(); i++) {
+                kmp_intptr a = held[e.second][i];
+                uint32_t   s = hash(a);
+                int        w = find(s, a);
+
+                if (--set[s][w].refs == 0) {
+                    set[s].erase(set[s].begin() + w);
+                    --used;
+                }
+            }
+
+            held[e.second].clear();
+
+            for (size_t i = 0; i < child[e.second].size(); i++) {
+                uint32_t k = child[e.second][i];
+
+                if (--left[k] == 0 && submitted[k]) {
+                    ready.push(k);
+                }
+            }
+
+            start(e.first);
+        }
+    }
+
+    /* Hold the producer until cond holds, counting the cycles on s
+     *  return: false if cond can never hold */
+    template<typename C>
+    bool stall(uint64_t& now, uint64_t& s, C cond) {
+        while (!cond()) {
+            if (running.empty()) {
+                return false;
+            }
+
+            uint64_t t = std::max(now, running.top().first);
+
+            s  += t - now;
+            now = t;
+
+            complete(now);
+        }
+
+        return true;
+    }
+};
+
+bool TaskLab::simulate(const tcfg& c) {
+    if (!prepare()) {
+        return false;
+    }
+
+    if (c.sets == 0 || c.ways == 0 || c.queue == 0) {
+        fprintf(stderr, "[ERROR] Invalid dependency table.\n");
+
+        return false;
+    }
+
+    std::vector<uint64_t> dur(pl->ntasks);
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        dur[t] = std::max(0.0, (pl->params[t].exec + 1.0) * tg->exec_t * c.cpi);
+    }
+
+    /* Same graph on an unbounded table, as reference */
+    tcfg inf = c;
+
+    inf.sets     = 1 << 16;
+    inf.ways     = (uint32_t)-1;
+    inf.queue    = (uint32_t)-1;
+    inf.max_deps = (uint32_t)-1;
+
+    TableSim sim(c, pl->ntasks, pl->dep_list, pl->dep_n, pl->pt, pl->pt_off, dur);
+    TableSim ref(inf, pl->ntasks, pl->dep_list, pl->dep_n, pl->pt, pl->pt_off, dur);
+
+    sim.run();
+    ref.run();
+
+    // The unbounded table looks every dependency up exactly once
+    uint64_t ndeps = 0;
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        ndeps += pl->dep_n[t] - 1;
+    }
+
+    if (ref.inserts + ref.hits != ndeps) {
+        fprintf(stderr, "[ERROR] The table saw %llu dependencies out of %llu.\n",
+                (unsigned long long)(ref.inserts + ref.hits),
+                (unsigned long long)ndeps);
+
+        return false;
+    }
+
+    uint64_t ns  = std::max(pl->ntasks, (uint32_t)1);
+    uint64_t nd  = sim.inserts + sim.hits;
+    uint64_t stl = sim.s_queue + sim.s_set + sim.s_limit;
+
+    printf("--- Dependency table simulation\n");
+    printf("\tTable:                %u sets x %u ways, %u queue entries, \
+%u deps per task, %u workers\n", c.sets, c.ways, c.queue, c.max_deps,
+           c.workers);
+    printf("\tSimulated time:       %llu cycles (%llu on an unbounded table, \
+%.2fx)\n", (unsigned long long)sim.time, (unsigned long long)ref.time,
+           ref.time ? (double)sim.time / ref.time : 0);
+    printf("\tProducer stalls:      %llu cycles (queue full %llu, set conflict \
+%llu, over dep. limit %llu)\n", (unsigned long long)stl,
+           (unsigned long long)sim.s_queue, (unsigned long long)sim.s_set,
+           (unsigned long long)sim.s_limit);
+    printf("\tDependencies:         %llu (%.1f%% found on the table)\n",
+           (unsigned long long)nd, nd ? 100.0 * sim.hits / nd : 0);
+    printf("\tConflicts:            %llu (%.2f%% of insertions)\n",
+           (unsigned long long)sim.conflicts,
+           sim.inserts ? 100.0 * sim.conflicts / sim.inserts : 0);
+    printf("\tTasks over the limit: %llu\n", (unsigned long long)sim.over);
+    printf("\tTable occupancy:      avg. %.1f, max. %llu of %llu entries\n",
+           (double)sim.occ_sum / ns, (unsigned long long)sim.occ_max,
+           (unsigned long long)c.sets * c.ways);
+    printf("\tQueue occupancy:      avg. %.1f, max. %llu of %u entries\n",
+           (double)sim.q_sum / ns, (unsigned long long)sim.q_max, c.queue);
+
+    return true;
+}
@@ -8,6 +8,11 @@
 
 #include <cstdio>
 #include <dlfcn.h>              // find function symbols
+#include <chrono>               // execution time
+#include <sys/mman.h>           // variable layouts
+#include <unistd.h>
+#include <unordered_set>
+#include <new>                  // runs of several graphs
 
 #include <boost/filesystem.hpp> // burnin utilities
 
@@ -19,20 +24,48 @@ namespace fs = boost::filesystem;
 /* ************************
  * Dispatch function symbols
  * ************************ */
-typedef void  (*fc_t)(ident*, kmp_int32, kmpc_micro, ...);
-typedef void *(*ta_t)(ident*, kmp_int32, kmp_int32, kmp_uint32, kmp_uint32, kmp_routine_entry);
-typedef void  (*td_t)(ident*, kmp_int32, kmp_task*, kmp_int32, kmp_depend_info*, kmp_int32, kmp_depend_info*);
-typedef void  (*tw_t)(ident*, kmp_int32);
-
-typedef void  (*tp_t)();
-
 fc_t fork_call          = NULL;
 ta_t omp_task_alloc     = NULL;
 td_t omp_task_with_deps = NULL;
 tw_t omp_taskwait       = NULL;
+mt_t omp_max_threads    = NULL;
 
 tp_t pretty_dump        = NULL;
 
+/* ************************
+ * Time helpers
+ * ************************ */
+/* Current time, in seconds */
+static double now() {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Current time, in nanoseconds. Read by every thread from its own clock, so
+ * that stamping tasks shares no counter between them */
+static uint64_t stamp() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* ***************
+ * Run configuration
+ * *************** */
+run_config::run_config() : dispatch(Dispatch::SERIAL),
+                           producers(std::max(std::thread::hardware_concurrency(),
+                                              1u)),
+                           chunk(DEFAULT_CHUNK), validate(true),
+                           analyze(false), lag(DEFAULT_LAG),
+                           arrival(Arrival::CLOSED), rate(DEFAULT_RATE),
+                           burst(DEFAULT_BURST), max_tasks(0),
+                           max_deps(0), layout(Layout::DENSE),
+                           stride(DEFAULT_STRIDE), region(DEFAULT_REGION),
+                           payload(0), kernel(Kernel::SPIN),
+                           wset(DEFAULT_WSET), counters(false),
+                           affinity(Affinity::FREE), cpus(""),
+                           placement(Placement::LEAVE), node(0),
+                           iters(1), overlap(false) {};
+
 /* ***************
  * Task structure handler
  *   -- for tasklab own INTERNAL validation!
@@ -51,6 +84,179 @@ bool _task::hasdep(uint32_t ID) {
     return false;
 }
 
+bool _task::haspred(uint32_t ID) {
+    /* Iterate over predecessors in order to try to find the ID */
+    std::list<_dep>::iterator it;
+    for (it = predecessors.begin(); 
+         it != predecessors.end(); ++it) {
+        if (it->dID == ID) {
+            return true;
+        }
+    }
+
+    /* None was found */
+    return false;
+}
+
+/* ************************
+ * Duration model
+ * ************************ */
+duration_s::duration_s() : dist(Dist::UNIFORM), spread(0),
+                           shape(DEFAULT_PARETO_SHAPE),
+                           frac(DEFAULT_BIMODAL_FRAC),
+                           ratio(DEFAULT_BIMODAL_RATIO),
+                           corr(Corr::FLAT), weight(0) {};
+
+bool duration_s::load(const char* filename) {
+    std::ifstream ifs(filename);
+
+    if (!ifs.is_open()) {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't load histogram.\n");
+
+        return false;
+    }
+
+    lo.clear();
+    hi.clear();
+    w.clear();
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        float l, h, c;
+
+        // Skip comments and malformed lines
+        if (line.empty() || line[0] == '#' ||
+            sscanf(line.c_str(), "%f %f %f", &l, &h, &c) != 3) {
+            continue;
+        }
+
+        if (l < 0 || h < l || c < 0) {
+            fprintf(stderr, "[ERROR] Invalid histogram bin \"%s\".\n",
+                    line.c_str());
+
+            return false;
+        }
+
+        lo.push_back(l);
+        hi.push_back(h);
+        w.push_back(c);
+    }
+
+    if (w.empty()) {
+        fprintf(stderr, "[ERROR] Histogram \"%s\" has no bins.\n", filename);
+
+        return false;
+    }
+
+    // Normalize bins by the mean of the histogram and keep weights as a
+    // cumulative sum, so sampling is a single search
+    double mean = 0, tw = 0;
+
+    for (size_t i = 0; i < w.size(); i++) {
+        mean += w[i] * (lo[i] + hi[i]) / 2;
+        tw   += w[i];
+        w[i]  = tw;
+    }
+
+    if (tw == 0 || mean == 0) {
+        fprintf(stderr, "[ERROR] Histogram \"%s\" is empty.\n", filename);
+
+        return false;
+    }
+
+    mean /= tw;
+
+    for (size_t i = 0; i < w.size(); i++) {
+        lo[i] /= mean;
+        hi[i] /= mean;
+    }
+
+    return true;
+}
+
+float duration_s::sample(std::mt19937& gen, const float max_r) {
+    std::uniform_real_distribution<float> u(0, 1);
+    float s = spread > 0 ? spread : max_r;
+    float m;
+
+    switch (dist) {
+        case Dist::NORMAL:
+        {
+            if (s <= 0) {
+                m = 1;
+                break;
+            }
+
+            // Truncated at 0 by drawing again, then scaled back to a mean of
+            // 1 (the truncated one being 1 + s * pdf(1/s) / cdf(1/s))
+            std::normal_distribution<float> n(1, s);
+
+            do {
+                m = n(gen);
+            } while (m < 0);
+
+            double a = 1 / s;
+
+            m /= 1 + s * (exp(-a * a / 2) / sqrt(2 * M_PI)) /
+                         (erfc(-a / sqrt(2)) / 2);
+            break;
+        }
+
+        case Dist::LOGNORMAL:
+            // mu is chosen so that the mean is 1
+            m = std::lognormal_distribution<float>(-s * s / 2, s)(gen);
+            break;
+
+        case Dist::EXPONENTIAL:
+            m = std::exponential_distribution<float>(1)(gen);
+            break;
+
+        case Dist::PARETO:
+        {
+            // Scale x_m is chosen so that the mean is 1 (needs shape > 1)
+            float a  = shape > 1 ? shape : DEFAULT_PARETO_SHAPE;
+            float xm = (a - 1) / a;
+
+            m = xm / pow(1 - u(gen), 1 / a);
+            break;
+        }
+
+        case Dist::BIMODAL:
+        {
+            // Short tasks take "1/ratio" of long ones
+            float sh = 1 / (1 - frac + frac * ratio);
+
+            m = u(gen) < frac ? sh * ratio : sh;
+            break;
+        }
+
+        case Dist::EMPIRICAL:
+        {
+            if (w.empty()) {
+                m = 1;
+                break;
+            }
+
+            // Pick a bin by its weight and a value within the bin
+            size_t i = std::upper_bound(w.begin(), w.end(), u(gen) * w.back())
+                       - w.begin();
+            i = std::min(i, w.size() - 1);
+
+            m = lo[i] + u(gen) * (hi[i] - lo[i]);
+            break;
+        }
+
+        case Dist::UNIFORM:
+        default:
+            // Randomly set load time of task (negative or positive)
+            m = 1 + (u(gen) * 2 - 1) * s;
+            break;
+    }
+
+    /* Durations can't be negative */
+    return std::max(m, 0.0f);
+}
+
 /* ************************
  * Task graph builders
  * ************************ */
@@ -76,10 +282,6 @@ void TaskGraph::create_tasks(const uint32_t max_dep) {
     /* First task */
     tasks[0].tID = 0;
 
-    // Randomly set load time of task (negative or positive)
-    tasks[0].exec = (rand() % 2) == 0 ? 1 : -1;
-    tasks[0].exec *= (float)(rand() % 100)/100 * max_r;
-
     /* Iterate over tasks */
     for (uint32_t i = 1; i < ntasks; i++) {
         uint32_t range_min, range_max;
@@ -106,10 +308,6 @@ void TaskGraph::create_tasks(const uint32_t max_dep) {
         // are soon-to-be parents able to take care of the no. of dep.?
         cur_dep = std::min(cur_dep, range_max - range_min);
 
-        // Randomly set load time of task (negative or positive)
-        tasks[i].exec = (rand() % 2) == 0 ? 1 : -1;
-        tasks[i].exec *= (float)(rand() % 100)/100 * max_r;
-
         // Generate a number in the range 1 to cur_dep
         npred = cur_dep == 0 ? 1 : rand() % cur_dep + 1;
 
@@ -125,6 +323,168 @@ void TaskGraph::create_tasks(const uint32_t max_dep) {
         // By default, no. of variables := no. of deps
         nvar  = ndeps;
     }
+
+    /* -- Set load time of tasks, now that the structure is known */
+    assign_durations();
+}
+
+void TaskGraph::assign_durations() {
+    std::mt19937       gen(rand());
+    std::vector<float> prop(ntasks, 1);  // property durations correlate with
+    double             sum = 0;
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        if (dur.corr == Corr::NDEPS) {
+            prop[i] = tasks[i].predecessors.size();
+        } else if (dur.corr == Corr::DEPTH) {
+            // Depth is one more than the deepest predecessor
+            prop[i] = 0;
+
+            std::list<_dep>::iterator it;
+            for (it = tasks[i].predecessors.begin();
+                 it != tasks[i].predecessors.end(); ++it) {
+                prop[i] = std::max(prop[i], prop[it->task] + 1);
+            }
+        }
+
+        sum += prop[i];
+    }
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        float m = dur.sample(gen, max_r);
+
+        // Scale by the property relative to its mean, keeping mean load
+        if (dur.corr != Corr::FLAT && sum > 0) {
+            m *= (1 - dur.weight) + dur.weight * prop[i] * ntasks / sum;
+        }
+
+        // exec is kept as the offset from standard execution size
+        tasks[i].exec = m - 1;
+    }
+}
+
+void TaskGraph::create_layers(const uint32_t nlvl, const float density,
+                              const std::vector<float>* widths) {
+    /* Keep in track with the id of each dependency */
+    uint32_t dep_id = 0;
+
+    /* First task of each level, plus the total no. of tasks */
+    std::vector<uint32_t> bound;
+    std::vector<double>   cum(1, 0);
+
+    for (uint32_t l = 0; l < nlvl; l++) {
+        cum.push_back(cum.back() + (widths ? (*widths)[l] : 1));
+    }
+
+    for (uint32_t l = 0; l <= nlvl; l++) {
+        uint32_t b = round(ntasks * cum[l] / cum.back());
+
+        // Every level gets at least one task
+        if (l > 0) {
+            b = std::max(b, bound.back() + 1);
+        }
+
+        bound.push_back(std::min(b, ntasks));
+    }
+
+    // Tasks of the first level have no predecessors, others make up for it
+    float d = nlvl > 1 ? density * ntasks / (ntasks - bound[1]) : 0;
+
+    ndeps = 0;
+    dep_r = 0;
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        tasks[i].tID = i;
+        tasks[i].predecessors.clear();
+        tasks[i].successors.clear();
+    }
+
+    for (uint32_t l = 1; l + 1 < bound.size(); l++) {
+        uint32_t prev  = bound[l - 1];     // first task of previous level
+        uint32_t start = bound[l];         // first task of current level
+        uint32_t end   = bound[l + 1];
+
+        for (uint32_t i = start; i < end; i++) {
+            std::vector<uint32_t> results;
+
+            // Draw no. of predecessors around the density, at least one
+            uint32_t npred = d;
+            npred += (float)(rand() % 100) / 100 < d - npred ? 1 : 0;
+            npred  = std::min(std::max(npred, (uint32_t)1), start);
+
+            for (uint32_t j = 0; j < npred; j++) {
+                _dep pred;
+
+                if (j == 0) {
+                    // Spread children over the whole previous level
+                    pred.task = prev + (i - start) % (start - prev);
+                } else if (npred <= start - prev) {
+                    // Further ones keep to the previous level...
+                    do {
+                        pred.task = prev + rand() % (start - prev);
+                    } while (std::find(results.begin(), results.end(),
+                             pred.task) != results.end());
+                } else {
+                    // ...unless it is too narrow
+                    do {
+                        pred.task = rand() % start;
+                    } while (std::find(results.begin(), results.end(),
+                             pred.task) != results.end());
+                }
+
+                results.push_back(pred.task);
+
+                // Set a random type for the dependency, either IN or INOUT
+                pred.type = Type(rand() % 2) == 0 ? 1 : 3;
+
+                tasks[i].predecessors.push_back(pred);
+                link(i, tasks[i].predecessors.back(), &dep_id);
+
+                dep_r = std::max(dep_r, i - pred.task);
+            }
+
+            ndeps += npred;
+        }
+    }
+
+    nvar = ndeps;
+
+    assign_durations();
+}
+
+double TaskGraph::span() {
+    std::vector<double> finish(ntasks, 0);
+    double              s = 0;
+
+    // Tasks only rely on previous ones, so one pass suffices
+    for (uint32_t i = 0; i < ntasks; i++) {
+        double start = 0;
+
+        std::list<_dep>::iterator it;
+        for (it = tasks[i].predecessors.begin();
+             it != tasks[i].predecessors.end(); ++it) {
+            start = std::max(start, finish[it->task]);
+        }
+
+        finish[i] = start + ((double)tasks[i].exec * exec_t) + exec_t;
+        s = std::max(s, finish[i]);
+    }
+
+    return s;
+}
+
+double TaskGraph::work() {
+    double w = 0;
+
+    for (uint32_t i = 0; i < ntasks; i++) {
+        w += ((double)tasks[i].exec * exec_t) + exec_t;
+    }
+
+    return w;
+}
+
+void TaskGraph::set_duration(const dmodel& dm) {
+    dur = dm;
 }
 
 void TaskGraph::describe_deps(const uint32_t tID, uint32_t* dep_id, 
@@ -148,30 +508,35 @@ void TaskGraph::describe_deps(const uint32_t tID, uint32_t* dep_id,
 
         // Set a random type for the dependency, either IN or INOUT
         it->type = Type(rand() % 2) == 0 ? 1 : 3;
-        it->dID = it->var = *dep_id;
 
-        // Set itself as a successor dependency (in case someone relies 
-        // on this variable, aka *dep_id for us)
-        _dep c_dep;                      // current dependency
-        c_dep.task = 0;                  // irrelevant
-        c_dep.type = it->type;           // type of current dependency
-        c_dep.dID = c_dep.var = *dep_id; // current id
+        link(tID, *it, dep_id);
+    }
+}
 
-        // Add it to itself
-        tasks[tID].successors.push_back(c_dep);
+void TaskGraph::link(const uint32_t tID, _dep& p, uint32_t* dep_id) {
+    p.dID = p.var = *dep_id;
 
-        // "Backwards" dependency with its parent, parent earns a new 
-        // variable to write on!
-        _dep b_dep;
-        b_dep.task = tID;
-        b_dep.type = Type::OUT;
-        b_dep.dID = b_dep.var = *dep_id;
+    // Set itself as a successor dependency (in case someone relies 
+    // on this variable, aka *dep_id for us)
+    _dep c_dep;                      // current dependency
+    c_dep.task = 0;                  // irrelevant
+    c_dep.type = p.type;             // type of current dependency
+    c_dep.dID = c_dep.var = *dep_id; // current id
 
-        // Set it as a successor at predecessor task
-        tasks[it->task].successors.push_back(b_dep);
+    // Add it to itself
+    tasks[tID].successors.push_back(c_dep);
 
-        (*dep_id)++;
-    }
+    // "Backwards" dependency with its parent, parent earns a new 
+    // variable to write on!
+    _dep b_dep;
+    b_dep.task = tID;
+    b_dep.type = Type::OUT;
+    b_dep.dID = b_dep.var = *dep_id;
+
+    // Set it as a successor at predecessor task
+    tasks[p.task].successors.push_back(b_dep);
+
+    (*dep_id)++;
 }
 
 /* ***************
@@ -338,11 +703,14 @@ void TaskLab::generate(const uint32_t n, const uint32_t m,
                        const uint32_t t = DEFAULT_EXECUTION_SIZE, 
                        const float    r = DEFAULT_EXECUTION_RANGE) {
     /* If there was something there, get rid of it! */
+    invalidate();
+
     if (tg != NULL) {
         delete tg;
     }
 
     tg = new TaskGraph(n, d, t, r);
+    tg->set_duration(dm);
 
     /* Seed random generator */
     srand(time(NULL));
@@ -351,172 +719,597 @@ void TaskLab::generate(const uint32_t n, const uint32_t m,
     tg->create_tasks(m);
 }
 
-bool TaskLab::run(const uint8_t rt) {
-    /* Check if there is a high task graph available to be dispatched */
-    if (empty(HTASK)) {
-        fprintf(stderr, "[ERROR] There isn't any graph to be dispatched!\n");
+bool TaskLab::layered(const uint32_t n, const double w, const double s,
+                      const float e, const std::vector<float>* widths) {
+    if (n == 0 || w <= 0 || (widths == NULL && s <= 0)) {
+        fprintf(stderr, "[ERROR] Invalid targets for a layered graph.\n");
 
         return false;
     }
 
-    tg_t = tg;       // set temp. task graph
-    r_error = false; // for now, it wans't found any error
+    /* If there was something there, get rid of it! */
+    invalidate();
 
-    /* Initialize runtime functions based on the runtime */
-    if (!init_run(rt)) {
-        /* Uh oh! Something went wrong! */
-        return false;
+    if (tg != NULL) {
+        delete tg;
     }
 
-    if (rt == RT::MTSP) {
-        // Start execution of a parallel region
-        fork_call(NULL, 0, (kmpc_micro) microtask);
-    }
+    tg = new TaskGraph(n, DEFAULT_DEP_RANGE,
+                       std::max(1.0, round(w / n)), DEFAULT_EXECUTION_RANGE);
+    tg->set_duration(dm);
 
-    tg_t = NULL;    // clean up your mess!
+    /* Seed random generator, every attempt replays the same stream */
+    uint32_t seed = time(NULL);
 
-    /* Was the execution successful? */
-    if (r_error) {
-        /* Error found, set r_error to its default value */
-        r_error = false;
+    uint32_t nlvl;
 
-        printf("[ERROR] The graph did not executed correctly!\n");
+    if (widths != NULL) {
+        nlvl = std::min((uint32_t)widths->size(), n);
 
-        return false;
+        srand(seed);
+        tg->create_layers(nlvl, e, widths);
     } else {
-        /* Everything went fine! */
-        return true;
-    }
-}
+        /* Search the no. of levels whose critical path is closest to the
+         * span, which grows with the no. of levels */
+        uint32_t lo = 1, hi = n, best = 1;
+        double   best_e = -1;
 
-/* ***************
- * Helper functions regarding simulation
- * *************** */
-void TaskLab::burnin(const uint32_t nruns, const uint32_t max_t, const uint8_t rt) {
-    uint32_t n, m, d, i;
-    bool     r = false;
-    char     gr_n[100]; // graph name
+        while (lo <= hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+
+            srand(seed);
+            tg->create_layers(mid, e);
+
+            double cur = tg->span();
+            double err = fabs(cur - s) / s;
 
-    uint32_t e = 0;     // keep track of the errors;
+            if (best_e < 0 || err < best_e) {
+                best   = mid;
+                best_e = err;
+            }
 
-    /* Generate nruns graphs */
-    for (i = 0; i < nruns; i++) {
-        /* Seed random generator */
-        srand(time(NULL) + i);
+            if (err <= DEFAULT_TOLERANCE) {
+                break;
+            } else if (cur < s) {
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
 
-        n = rand() % max_t + 1;
-        m = rand() % 30;        // set number of dependencies
-        d = rand() % 20;        // set max. distance from predecessor
+        nlvl = best;
 
-        fprintf(stdout, "%u) Generating task graph of %d tasks...\n", i, n);
+        srand(seed);
+        tg->create_layers(nlvl, e);
+    }
 
-        generate(n, m, d);
+    /* Report achieved values */
+    double a_w = tg->work();
+    double a_s = tg->span();
+    double a_e = (double)tg->ndeps / n;
+    double t_s = widths ? a_s : s;
 
-        fprintf(stdout, "\tDone generation!\n");
+    printf("--- Layered graph\t\t target \t achieved\n");
+    printf("\tTasks:       %14u \t %14u\n", n, n);
+    printf("\tLevels:      %14s \t %14u\n", "-", nlvl);
+    printf("\tWork:        %14.0f \t %14.0f\n", w, a_w);
 
-        r = run(rt);
+    if (widths) {
+        printf("\tSpan:        %14s \t %14.0f\n", "-", a_s);
+        printf("\tParallelism: %14s \t %14.2f\n", "-", a_w / a_s);
+    } else {
+        printf("\tSpan:        %14.0f \t %14.0f\n", s, a_s);
+        printf("\tParallelism: %14.2f \t %14.2f\n", w / s, a_w / a_s);
+    }
 
-        /* If there was en error */
-        if (!r) {
-            sprintf(gr_n, "%s_failed_%04d", DEFAULT_NAME, e++);
+    printf("\tEdges/task:  %14.2f \t %14.2f\n", e, a_e);
 
-            /* Save graph as both formats */
-            save(gr_n);
-            plot(gr_n, DOT);
-            plot(gr_n, LL);
-            plot(gr_n, INFO);
+    bool hit = fabs(a_w - w) / w <= DEFAULT_TOLERANCE &&
+               fabs(a_s - t_s) / t_s <= DEFAULT_TOLERANCE;
 
-            fprintf(stderr, "Execution failed!\n\tFile saved and plotted as \
-'%s'.\n\n", gr_n);
-        }
+    if (!hit) {
+        printf("[WARNING] Targets not hit within %.0f%%.\n",
+               DEFAULT_TOLERANCE * 100);
     }
+
+    return hit;
 }
 
-void TaskLab::burnin(const char* path, const uint16_t n, const uint8_t rt) {
-    /* Is the path correct? */
-    if (!fs::exists(path) || !fs::is_directory(path)) {
-        fprintf(stderr, "[ERROR] Directory \"%s\" does not exist.\n", path);
+bool TaskLab::nested(const uint8_t shape, const uint32_t n,
+                     const uint32_t cutoff, const bool wait, const uint32_t t) {
+    if (n == 0 || shape < Shape::FIB || shape > Shape::BHTREE) {
+        fprintf(stderr, "[ERROR] Invalid problem for a nested graph.\n");
 
-        return;
+        return false;
     }
 
-    // save graph into internal representation
-    const char* filename_ = "burnin_feedback.txt";
-    std::ofstream ofs (filename_, std::ofstream::out);
+    /* If there was something there, get rid of it! */
+    invalidate();
 
-    bool r = false;
-    fs::recursive_directory_iterator it(path);
-    fs::recursive_directory_iterator endit;
+    if (tg != NULL) {
+        delete tg;
+    }
 
-    while(it != endit)
-    {
-        /* Check if it is a valid file */
-        if (fs::is_regular_file(*it) && it->path().extension() == ".dat") {
-            const char* cur_f = add_extension("/", it->path().stem().c_str());
-            const char* cur_p = add_extension(it->path().parent_path().c_str(), cur_f);
+    tg = new TaskGraph(0, DEFAULT_DEP_RANGE, t, DEFAULT_EXECUTION_RANGE);
 
-            /* Restore it */
-            restore(cur_p);
+    /* Seed random generator */
+    srand(time(NULL));
 
-			std::cout << "Executing " << cur_p << "\n";
-            ofs << "Execution of " << cur_p << "\n";
+    if (!tg->create_nested(shape, n, cutoff, wait)) {
+        fprintf(stderr, "[ERROR] The recursion tree exceeds %u tasks, try a \
+larger cutoff.\n", MAX_NESTED);
 
-            for (int i = 0; i < n; ++i) {
-                r = run(rt);
+        return false;
+    }
 
-                if (!r) {
-                    ofs << "\t" << i + 1 << ": failed.\n";
-                } else {
-                    ofs << "\t" << i + 1 << ": success! \n";
-                }
-            }
+    /* Report the shape of the tree */
+    std::vector<uint32_t> depth(tg->ntasks, 0);
+    uint32_t              leaves = 0, max_d = 0;
 
-            ofs << "\n";
-        }
+    for (uint32_t i = 0; i < tg->ntasks; i++) {
+        uint32_t p = tg->tasks[i].parent;
 
-        ++it;
+        // Parents come before their children
+        depth[i] = p == (uint32_t)NONE ? 0 : depth[p] + 1;
+        max_d    = std::max(max_d, depth[i]);
+
+        // Every child is a variable written by its parent
+        if (tg->tasks[i].successors.size() == tg->tasks[i].predecessors.size()) {
+            ++leaves;
+        }
     }
 
-    fprintf(stdout, "Success! Output is at %s\n", filename_);
+    const char* name[] = { "", "Fibonacci", "quicksort", "Barnes-Hut" };
 
-    ofs.close();
+    printf("--- Nested graph (%s of %u, cutoff %u)\n", name[shape], n, cutoff);
+    printf("\tTasks:       %14u\n", tg->ntasks);
+    printf("\tLeaves:      %14u\n", leaves);
+    printf("\tDepth:       %14u\n", max_d + 1);
+    printf("\tWork:        %14.0f\n", tg->work());
+    printf("\tSpan:        %14.0f\n", tg->span());
+    printf("\tParallelism: %14.2f\n", tg->work() / tg->span());
+    printf("\tParents %s for their children\n", wait ? "wait" : "do not wait");
+
+    return true;
 }
 
-/* ***************
- * Trace functions
- * *************** */
-bool TaskLab::hasEvent(const uint8_t event) {
-    if (event < EVENT_S) {
-        /* Return if event is set */
-        return t_e[event];
-    } else {
-        /* Event not found */
+bool TaskLab::duration(const dmodel& m) {
+    // Weights above 1 would make durations of low-property tasks negative
+    if (m.corr != Corr::FLAT && (m.weight < 0 || m.weight > 1)) {
+        fprintf(stderr, "[ERROR] The strength of a correlation must be within \
+0 and 1.\n");
+
         return false;
     }
-}
 
-void TaskLab::watchEvent(const uint8_t event) {
-    if (event < EVENT_S) {
-        /* Set it to be watched */
-        t_e[event] = true;
-    } else {
-        fprintf(stderr, "[ERROR] Event is not supported.\n");
+    if (m.dist == Dist::BIMODAL && (m.frac < 0 || m.frac > 1 || m.ratio <= 0)) {
+        fprintf(stderr, "[ERROR] Bimodal durations need a fraction within 0 \
+and 1 and a positive ratio.\n");
+
+        return false;
     }
-}
 
-void TaskLab::eventOccurred(const uint8_t event, const void* t_p) {
-    switch (event) {
-        case Evt::HTASK:
-        {
-            task t = *(task*) t_p;
+    dm = m;
 
-            /* If there isn't a task graph instantiated yet */
-            if (empty()) {
+    return true;
+}
+
+bool TaskLab::run(const uint8_t rt) {
+    /* Runs follow the configuration they started with, on a plan no other
+     * run is using */
+    rcfg    c = cfg;
+    plan_t* p = claim(c);
+
+    if (p == NULL) {
+        return false;
+    }
+
+    /* Initialize runtime functions based on the runtime */
+    if (!init_run(rt)) {
+        /* Uh oh! Something went wrong! */
+        release(p);
+
+        return false;
+    }
+
+    settle(c, p, rt);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    region_t rg;                // parallel region of the run
+    tenant_t tn(tg, p, c);      // and its only graph
+
+    rg.tn.assign(1, &tn);
+    rg.mix = Mix::PER_PRODUCER;
+    tn.pc  = &rg.pc;
+
+    place_start(&rg.pc, &tn);
+
+    // Tasks count events only if the counters could be opened
+    tn.cfg.counters = c.counters && ctr_start();
+
+    if (rt == RT::MTSP) {
+        // Start execution of a parallel region
+        fork_call(NULL, 1, (kmpc_micro) microtask, &rg);
+    }
+
+    std::chrono::duration<double, std::milli> el =
+        std::chrono::steady_clock::now() - t0;
+
+    printf("\tExecution time: %.3f ms\n", el.count());
+
+    if (c.affinity != Affinity::FREE || c.placement != Placement::LEAVE) {
+        place_report(&rg.pc, tn);
+    }
+
+    if (tn.cfg.counters) {
+        ctr_report(rg.tn);
+    }
+
+    bool ok = report(tn);
+
+    release(p);
+
+    return ok;
+}
+
+bool TaskLab::run(const std::vector<TaskLab*>& labs, const uint8_t rt,
+                  const uint8_t mix) {
+    if (labs.empty()) {
+        fprintf(stderr, "[ERROR] There isn't any graph to be dispatched.\n");
+
+        return false;
+    }
+
+    std::vector<rcfg>    c;
+    std::vector<plan_t*> p;
+
+    /* A lab listed twice runs its graph alongside itself, on a plan of its
+     * own for each run */
+    for (size_t k = 0; k < labs.size(); k++) {
+        c.push_back(labs[k]->cfg);
+        p.push_back(labs[k]->claim(c[k]));
+
+        if (p[k] == NULL) {
+            for (size_t j = 0; j < k; j++) {
+                labs[j]->release(p[j]);
+            }
+
+            return false;
+        }
+    }
+
+    /* Initialize runtime functions based on the runtime */
+    if (!labs[0]->init_run(rt)) {
+        for (size_t k = 0; k < labs.size(); k++) {
+            labs[k]->release(p[k]);
+        }
+
+        /* Uh oh! Something went wrong! */
+        return false;
+    }
+
+    for (size_t k = 0; k < labs.size(); k++) {
+        settle(c[k], p[k], rt);
+
+        // A single thread takes turns over the graphs, once each
+        if (mix == Mix::INTERLEAVED && (c[k].dispatch != Dispatch::SERIAL ||
+            c[k].arrival != Arrival::CLOSED || c[k].iters > 1)) {
+            fprintf(stderr, "[WARNING] Interleaved graphs are dispatched once, \
+in closed loop, by a single thread (graph %zu).\n", k);
+
+            c[k].dispatch = Dispatch::SERIAL;
+            c[k].arrival  = Arrival::CLOSED;
+            c[k].iters    = 1;
+        }
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    region_t rg;
+
+    rg.mix = mix;
+
+    // Window counters are on lines of their own, and so must be the state
+    for (size_t k = 0; k < labs.size(); k++) {
+        void* m;
+
+        if (posix_memalign(&m, CACHE_LINE, sizeof(tenant_t))) {
+            fprintf(stderr, "[ERROR] Couldn't allocate the run of graph %zu.\n", k);
+
+            for (size_t j = 0; j < labs.size(); j++) {
+                labs[j]->release(p[j]);
+            }
+
+            for (size_t j = 0; j < rg.tn.size(); j++) {
+                rg.tn[j]->~tenant_t();
+                free(rg.tn[j]);
+            }
+
+            return false;
+        }
+
+        rg.tn.push_back(new (m) tenant_t(labs[k]->tg, p[k], c[k]));
+
+        rg.tn[k]->shared = true;
+        rg.tn[k]->pc     = &rg.pc;
+    }
+
+    /* Threads (and counters) follow the first lab */
+    bool ctr = c[0].counters && ctr_start();
+
+    place_start(&rg.pc, rg.tn[0]);
+
+    for (size_t k = 0; k < rg.tn.size(); k++) {
+        rg.tn[k]->cfg.counters = ctr;
+    }
+
+    if (rt == RT::MTSP) {
+        // Start execution of a parallel region
+        fork_call(NULL, 1, (kmpc_micro) microtask, &rg);
+    }
+
+    std::chrono::duration<double, std::milli> el =
+        std::chrono::steady_clock::now() - t0;
+
+    printf("\tExecution time: %.3f ms (%zu graphs, %s)\n", el.count(),
+           labs.size(), mix == Mix::INTERLEAVED ? "interleaved" : "own producers");
+
+    if (c[0].affinity != Affinity::FREE || c[0].placement != Placement::LEAVE) {
+        place_report(&rg.pc, *rg.tn[0]);
+    }
+
+    if (ctr) {
+        ctr_report(rg.tn);
+    }
+
+    /* -- Each graph on its own */
+    bool ok = true;
+
+    for (size_t k = 0; k < labs.size(); k++) {
+        printf("--- Graph %zu: %u tasks\n", k, p[k]->ntasks);
+
+        ok = labs[k]->report(*rg.tn[k]) && ok;
+    }
+
+    /* -- Fairness, i.e. how evenly graphs progressed, as Jain's index over
+     * the work rate of each one: 1 if even, 1/n if a single one did */
+    double s = 0, s2 = 0;
+
+    printf("--- Graphs\n");
+    printf("\t\t%6s %10s %14s %14s\n", "graph", "tasks", "makespan (ms)",
+           "tasks/s");
+
+    for (size_t k = 0; k < rg.tn.size(); k++) {
+        tenant_t* tn   = rg.tn[k];
+        uint64_t  n    = (uint64_t)tn->pl->ntasks * tn->cfg.iters;
+        double    span = tn->t_done > tn->pl->t_run ?
+                         (tn->t_done - tn->pl->t_run) / 1e9 : 0;
+        double    rate = span > 0 ? tn->tg->work() * tn->cfg.iters / span : 0;
+
+        printf("\t\t%6zu %10llu %14.3f %14.0f\n", k, (unsigned long long)n,
+               span * 1e3, span > 0 ? n / span : 0);
+
+        s  += rate;
+        s2 += rate * rate;
+    }
+
+    printf("\tFairness (Jain's index over work rate): %.3f\n",
+           s2 > 0 ? s * s / (rg.tn.size() * s2) : 0);
+
+    for (size_t k = 0; k < labs.size(); k++) {
+        labs[k]->release(p[k]);
+
+        rg.tn[k]->~tenant_t();
+        free(rg.tn[k]);
+    }
+
+    return ok;
+}
+
+/* ***************
+ * Helper functions regarding simulation
+ * *************** */
+void TaskLab::burnin(const uint32_t nruns, const uint32_t max_t, const uint8_t rt,
+                     const uint32_t jobs) {
+    std::atomic<uint32_t> next(0);  // next graph to be generated
+    std::atomic<uint32_t> e(0);     // keep track of the errors;
+    std::mutex            gen_lock; // generation (re)seeds the global rand()
+
+    /* Every job runs its graphs on a lab of its own, the first on this one */
+    std::vector<TaskLab*> labs(1, this);
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        labs.push_back(new TaskLab());
+        labs[j]->configure(cfg);
+        labs[j]->duration(dm);
+    }
+
+    auto job = [&](TaskLab* l) {
+        uint32_t n, m, d, i;
+        bool     r = false;
+        char     gr_n[100]; // graph name
+
+        /* Generate nruns graphs */
+        while ((i = next++) < nruns) {
+            /* Seed random generator, one per graph so jobs don't share it */
+            std::mt19937 gen(time(NULL) + i);
+
+            n = gen() % max_t + 1;
+            m = gen() % 30;         // set number of dependencies
+            d = gen() % 20;         // set max. distance from predecessor
+
+            fprintf(stdout, "%u) Generating task graph of %d tasks...\n", i, n);
+
+            {
+                std::lock_guard<std::mutex> g(gen_lock);
+
+                l->generate(n, m, d);
+            }
+
+            fprintf(stdout, "\tDone generation!\n");
+
+            r = l->run(rt);
+
+            /* If there was en error */
+            if (!r) {
+                sprintf(gr_n, "%s_failed_%04d", DEFAULT_NAME, e++);
+
+                /* Save graph as both formats */
+                l->save(gr_n);
+                l->plot(gr_n, DOT);
+                l->plot(gr_n, LL);
+                l->plot(gr_n, INFO);
+
+                fprintf(stderr, "Execution failed!\n\tFile saved and plotted as \
+'%s'.\n\n", gr_n);
+            }
+        }
+    };
+
+    std::vector<std::thread> thr;
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        thr.push_back(std::thread(job, labs[j]));
+    }
+
+    job(this);
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        thr[j - 1].join();
+
+        delete labs[j];
+    }
+}
+
+void TaskLab::burnin(const char* path, const uint16_t n, const uint8_t rt,
+                     const uint32_t jobs) {
+    /* Is the path correct? */
+    if (!fs::exists(path) || !fs::is_directory(path)) {
+        fprintf(stderr, "[ERROR] Directory \"%s\" does not exist.\n", path);
+
+        return;
+    }
+
+    // save graph into internal representation
+    const char* filename_ = "burnin_feedback.txt";
+    std::ofstream ofs (filename_, std::ofstream::out);
+
+    std::vector<std::string> files;
+    fs::recursive_directory_iterator it(path);
+    fs::recursive_directory_iterator endit;
+
+    while(it != endit)
+    {
+        /* Check if it is a valid file */
+        if (fs::is_regular_file(*it) && it->path().extension() == ".dat") {
+            files.push_back(it->path().parent_path().string() + "/" +
+                            it->path().stem().string());
+        }
+
+        ++it;
+    }
+
+    /* Every job runs its files on a lab of its own, the first on this one,
+     * and feedback is written in file order */
+    std::vector<std::string> out(files.size());
+    std::atomic<size_t>      next(0);
+    std::vector<TaskLab*>    labs(1, this);
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        labs.push_back(new TaskLab());
+        labs[j]->configure(cfg);
+        labs[j]->duration(dm);
+    }
+
+    auto job = [&](TaskLab* l) {
+        bool   r = false;
+        size_t f;
+
+        while ((f = next++) < files.size()) {
+            const char* cur_p = files[f].c_str();
+
+            /* Restore it */
+            l->restore(cur_p);
+
+            std::cout << "Executing " << cur_p << "\n";
+            out[f] = "Execution of " + files[f] + "\n";
+
+            for (int i = 0; i < n; ++i) {
+                r = l->run(rt);
+
+                if (!r) {
+                    out[f] += "\t" + std::to_string(i + 1) + ": failed.\n";
+                } else {
+                    out[f] += "\t" + std::to_string(i + 1) + ": success! \n";
+                }
+            }
+
+            out[f] += "\n";
+        }
+    };
+
+    std::vector<std::thread> thr;
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        thr.push_back(std::thread(job, labs[j]));
+    }
+
+    job(this);
+
+    for (uint32_t j = 1; j < jobs; j++) {
+        thr[j - 1].join();
+
+        delete labs[j];
+    }
+
+    for (size_t f = 0; f < out.size(); f++) {
+        ofs << out[f];
+    }
+
+    fprintf(stdout, "Success! Output is at %s\n", filename_);
+
+    ofs.close();
+}
+
+/* ***************
+ * Trace functions
+ * *************** */
+bool TaskLab::hasEvent(const uint8_t event) {
+    if (event < EVENT_S) {
+        /* Return if event is set */
+        return t_e[event];
+    } else {
+        /* Event not found */
+        return false;
+    }
+}
+
+void TaskLab::watchEvent(const uint8_t event) {
+    if (event < EVENT_S) {
+        /* Set it to be watched */
+        t_e[event] = true;
+    } else {
+        fprintf(stderr, "[ERROR] Event is not supported.\n");
+    }
+}
+
+void TaskLab::eventOccurred(const uint8_t event, const void* t_p) {
+    switch (event) {
+        case Evt::HTASK:
+        {
+            task t = *(task*) t_p;
+
+            /* If there isn't a task graph instantiated yet */
+            if (empty()) {
                 tg = new TaskGraph();
             }
 
             tg->add_task(t);
 
+            /* The graph changed, so its plan is no longer valid */
+            invalidate();
+
             break;
         }
 
@@ -563,11 +1356,11 @@ bool TaskLab::save(const char* filename) {
     } else {
         fprintf(stderr, "[ERROR] Invalid filename. Couldn't save task graph.\n");
 
-        delete filename_;
+        delete[] filename_;
         return false;
     }
 
-    delete filename_;
+    delete[] filename_;
 
     return true;
 }
@@ -577,6 +1370,8 @@ bool TaskLab::restore(const char* filename) {
     const char* filename_ = add_extension(filename, ".dat");
 
     // if task graph is not empty, clean it up!
+    invalidate();
+
     if (!empty()) {
         delete tg;
         tg = NULL;
@@ -598,14 +1393,93 @@ bool TaskLab::restore(const char* filename) {
         fprintf(stderr, "[ERROR] Invalid filename. Couldn't restore task graph.\n");
 
         /* Throws away */
-        delete filename_;
+        delete[] filename_;
         delete tg;
         tg = NULL;
 
         return false;
     }
 
-    delete filename_;
+    delete[] filename_;
+
+    return true;
+}
+
+bool TaskLab::profile(const char* filename) {
+    /* Check if there is a task graph available */
+    if (empty(HTASK)) {
+        fprintf(stderr, "[ERROR] There isn't any high level graph to be profiled!\n");
+
+        return false;
+    }
+
+    gprofile p;
+    tg->profile(p);
+
+    const char* filename_ = add_extension(filename, ".prof");
+
+    std::ofstream ofs(filename_);
+
+    if (ofs.is_open()) {
+        boost::archive::text_oarchive oa(ofs);
+
+        oa << p;
+    } else {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't save profile.\n");
+
+        delete[] filename_;
+        return false;
+    }
+
+    delete[] filename_;
+
+    p.summary(stdout, "Profiled graph");
+
+    return true;
+}
+
+bool TaskLab::synthesize(const char* filename, const uint32_t n,
+                         const bool keep_span) {
+    const char* filename_ = add_extension(filename, ".prof");
+
+    gprofile p;
+
+    // open the archive
+    std::ifstream ifs(filename_);
+
+    if (ifs.is_open()) {
+        boost::archive::text_iarchive ia(ifs);
+
+        ia >> p;
+    } else {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't restore profile.\n");
+
+        delete[] filename_;
+        return false;
+    }
+
+    delete[] filename_;
+
+    /* If there was something there, get rid of it! */
+    invalidate();
+
+    if (tg != NULL) {
+        delete tg;
+    }
+
+    tg = new TaskGraph(n, DEFAULT_DEP_RANGE, p.exec_t, 0);
+
+    /* Seed random generator */
+    srand(time(NULL));
+
+    tg->synthesize(p, keep_span);
+
+    /* Report how close we got */
+    gprofile a;
+    tg->profile(a);
+
+    p.summary(stdout, "Target profile");
+    a.summary(stdout, "Synthesized graph");
 
     return true;
 }
@@ -678,7 +1552,7 @@ bool TaskLab::plot(const char* filename, const uint8_t fm) {
 
         ofs.close();
 
-        delete filename_;
+        delete[] filename_;
     } else if (fm == INFO) {
         /* Check if there is a task graph available */
         if (empty(HTASK)) {
@@ -732,6 +1606,11 @@ bool TaskLab::plot(const char* filename, const uint8_t fm) {
         ofs << "\t\tinout:                              " << dep_c[Type::INOUT] << "\n";
         ofs << "\t\tout:                                " << dep_c[Type::OUT] << "\n";
 
+        ofs << "\tCritical path (iterations):             " << std::fixed <<
+               std::setprecision(0) << tg->span() << "\n";
+        ofs << "\tAvg. parallelism (work/span):           " << std::fixed <<
+               std::setprecision(2) << tg->work() / tg->span() << "\n";
+
         ofs << "\n--- Information regarding randomly generated graphs \t---\n";
         ofs << "\tStandard amount of iterations per task: " << tg->exec_t << "\n";
 
@@ -742,7 +1621,7 @@ bool TaskLab::plot(const char* filename, const uint8_t fm) {
 
         ofs.close();
 
-        delete filename_;
+        delete[] filename_;
     }
 
     return true;
@@ -772,24 +1651,620 @@ bool TaskLab::empty(uint8_t evt) {
  * ************************ */
 TaskLab::TaskLab() {
     tg = NULL;
+    pl = NULL;
+}
+
+TaskLab::~TaskLab() {
+    invalidate();
+
+    if (tg != NULL) {
+        delete tg;
+    }
+}
+
+/* ************************
+ * Dispatch plan
+ * ************************ */
+TaskLab::dispatch_plan::dispatch_plan(TaskGraph* g, const rcfg& c) {
+    std::vector<_task>::iterator it;
+
+    /* Size pools from the no. of edges, so that dispatching does not
+     * allocate at all */
+    uint64_t n_pred = 0, n_succ = 0;
+
+    for (it = g->tasks.begin(); it != g->tasks.end(); ++it) {
+        n_pred += it->predecessors.size();
+        n_succ += it->successors.size();
+    }
+
+    /* -- Validation flags are laid out by the task writing them, every task
+     * on cache lines of its own: running tasks never write to the same line,
+     * and only read lines of tasks that already finished. A task re-writing
+     * the flag of one of its predecessors is the same as not writing it,
+     * since no one else reads it, so such flags are left to the parent. */
+    std::vector<uint64_t> slot(g->ndeps, (uint64_t)NONE);
+    std::vector<uint32_t> own;  // no. of flags each task writes
+
+    nchk = 0;
+
+    for (it = g->tasks.begin(); it != g->tasks.end(); ++it) {
+        std::list<_dep>::iterator itt;
+        uint32_t                  n = 0, w = 0;
+
+        for (itt = it->successors.begin(); itt != it->successors.end(); ++itt) {
+            if (it->haspred(itt->dID)) {
+                continue;
+            }
+
+            // Flags written by many tasks are placed by the first one
+            if (slot[itt->dID] == (uint64_t)NONE) {
+                slot[itt->dID] = nchk + n++;
+            }
+
+            ++w;
+        }
+
+        own.push_back(w);
+        nchk = (nchk + n + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    }
+
+    // Flags no one writes still need a place
+    for (uint32_t d = 0; d < g->ndeps; d++) {
+        if (slot[d] == (uint64_t)NONE) {
+            slot[d] = nchk++;
+        }
+    }
+
+    ntasks   = g->ntasks;
+
+    if (posix_memalign((void**)&dep_chk, CACHE_LINE, std::max(nchk, (uint64_t)1))) {
+        throw std::bad_alloc();
+    }
+
+    lay_out(g->nvar, c);
+
+    params   = new tparam_t[g->ntasks];
+    t_arr    = new uint64_t[g->ntasks];
+    t_sub    = new uint64_t[g->ntasks];
+    t_beg    = new uint64_t[g->ntasks];
+    t_end    = new uint64_t[g->ntasks];
+    t_thr    = new uint32_t[g->ntasks];
+    t_ctr    = new std::atomic<uint64_t>[(size_t)NCTR * g->ntasks];
+    r_left   = NULL;
+    chk_pool = new bool*[n_pred + n_succ];
+    dep_pool = new kmp_depend_info[n_succ + g->ntasks];
+    acc_pool = new bacc_t[c.payload > 0 ? 2 * n_succ : 0];
+    dep_list = new kmp_depend_info*[g->ntasks];
+    dep_n    = new uint32_t[g->ntasks];
+
+    /* Next free position on each pool */
+    bool**           chk_cur = chk_pool;
+    kmp_depend_info* dep_cur = dep_pool;
+    bacc_t*          acc_cur = acc_pool;
+
+    /* Version of each payload, i.e. ID (+ 1) of its last writer so far */
+    std::vector<uint64_t> ver(c.payload > 0 ? g->nvar : 0, 0);
+
+    for (it = g->tasks.begin(); it != g->tasks.end(); ++it) {
+        std::list<_dep>::iterator itt;
+
+        uint32_t  cur_task = it->tID; // Task id
+        tparam_t& p        = params[cur_task];
+
+        // -- Set our own data regarding task graph verification
+        p.tID    = cur_task;
+        p.exec   = it->exec;
+        p.kern   = kernel_of(c.kernel, cur_task);
+        p.pred_s = it->predecessors.size();
+        p.succ_s = own[cur_task];
+        p.parent = it->parent;
+        p.wait   = it->wait;
+
+        p.pred   = chk_cur;
+        chk_cur += p.pred_s;
+        p.succ   = chk_cur;
+        chk_cur += it->successors.size();
+
+        /* Edges between a task and the tasks it spawns are kept by spawning
+         * them, since the runtime only orders siblings */
+        auto spawned = [&](const _dep& e) {
+            return (e.type == Type::OUT && g->tasks[e.task].parent == cur_task) ||
+                   (it->parent != (uint32_t)NONE && it->haspred(e.dID));
+        };
+
+        /* Total of dependecies relying on different variables from current
+         * task, plus the pointer ref. */
+        dep_n[cur_task]    = 1;
+
+        for (itt = it->successors.begin(); itt != it->successors.end(); ++itt) {
+            dep_n[cur_task] += spawned(*itt) ? 0 : 1;
+        }
+
+        dep_list[cur_task] = dep_cur;
+        dep_cur           += dep_n[cur_task];
+
+        kmp_depend_info* d = dep_list[cur_task];
+
+        /* Set first position which will be used as pointer ref. */
+        d[0].base_addr = (kmp_intptr) &p;
+        d[0].len       = sizeof(p);
+        d[0].flags.in  = true;       // technically, this variable
+                                     // is read at the function
+        d[0].flags.out = false;
+
+        /* Pointer to our dep_list and validation indexes */
+        uint32_t i = 1, cur_succ = 0;
+
+        // -- Describe dependencies that will be dispatched
+        for (itt = it->successors.begin(); itt != it->successors.end(); ++itt) {
+            if (!spawned(*itt)) {
+                /* Address to rely on */
+                d[i].base_addr = vaddr[itt->var];
+                d[i].len       = vlen[itt->var];
+
+                /* Dependency type */
+                d[i].flags.in  = (itt->type != Type::OUT) ? true : false;
+                d[i].flags.out = (itt->type != Type::IN) ? true : false;
+
+                ++i;
+            }
+
+            // -- Dependency validation pointer, if written by the task
+            if (!it->haspred(itt->dID)) {
+                p.succ[cur_succ++] = &dep_chk[slot[itt->dID]];
+            }
+        }
+
+        // -- Set our own verifier
+        i = 0;
+        for (itt = it->predecessors.begin(); itt != it->predecessors.end(); ++itt) {
+            p.pred[i++] = &dep_chk[slot[itt->dID]];
+        }
+
+        // -- Payloads read, and then written, by the task (at the start of
+        //    their variables, which regions may make longer)
+        uint32_t pw = (c.payload + 7) / 8;
+
+        p.rd_s = p.wr_s = 0;
+        p.rd   = acc_cur;
+
+        for (itt = it->successors.begin();
+             c.payload > 0 && itt != it->successors.end(); ++itt) {
+            if (itt->type != Type::OUT) {
+                bacc_t a = { (uint64_t*)vaddr[itt->var], pw, ver[itt->var] };
+                p.rd[p.rd_s++] = a;
+            }
+        }
+
+        acc_cur += p.rd_s;
+        p.wr     = acc_cur;
+
+        for (itt = it->successors.begin();
+             c.payload > 0 && itt != it->successors.end(); ++itt) {
+            if (itt->type != Type::IN) {
+                bacc_t a = { (uint64_t*)vaddr[itt->var], pw,
+                             (uint64_t)cur_task + 1 };
+                p.wr[p.wr_s++] = a;
+
+                ver[itt->var] = cur_task + 1;
+            }
+        }
+
+        acc_cur += p.wr_s;
+    }
+
+    /* -- Tasks spawned by each task, contiguous per parent */
+    std::vector<uint32_t> off(ntasks + 1, 0);
+
+    busy   = false;
+    nested = false;
+    joined = true;
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        if (params[t].parent != (uint32_t)NONE) {
+            ++off[params[t].parent + 1];
+        }
+    }
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        off[t + 1] += off[t];
+    }
+
+    kid.resize(off[ntasks]);
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        params[t].kids   = kid.data() + off[t];
+        params[t].kids_s = 0;
+    }
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        uint32_t q = params[t].parent;
+
+        if (q != (uint32_t)NONE) {
+            params[q].kids[params[q].kids_s++] = t;
+
+            nested = true;
+            joined = joined && params[q].wait;
+        }
+    }
+
+    /* -- Predecessor tasks and topological levels, for producers */
+    std::vector<uint32_t> level(ntasks, 0);
+    uint32_t              nlvl = 0;
+
+    pt_off.assign(1, 0);
+    pt.reserve(n_pred);
+
+    for (it = g->tasks.begin(); it != g->tasks.end(); ++it) {
+        std::list<_dep>::iterator itt;
+
+        for (itt = it->predecessors.begin(); itt != it->predecessors.end(); ++itt) {
+            // Tasks only rely on previous ones
+            level[it->tID] = std::max(level[it->tID], level[itt->task] + 1);
+            pt.push_back(itt->task);
+        }
+
+        pt_off.push_back(pt.size());
+        nlvl = std::max(nlvl, level[it->tID] + 1);
+    }
+
+    // Counting sort of tasks by level, keeping ID order within a level
+    lvl.assign(nlvl + 1, 0);
+    order.resize(ntasks);
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        ++lvl[level[t] + 1];
+    }
+
+    for (uint32_t l = 0; l < nlvl; l++) {
+        lvl[l + 1] += lvl[l];
+    }
+
+    std::vector<uint32_t> pos(lvl.begin(), lvl.end() - 1);
+
+    for (uint32_t t = 0; t < ntasks; t++) {
+        order[pos[level[t]]++] = t;
+    }
+}
+
+void TaskLab::dispatch_plan::lay_out(const uint32_t nvar, const rcfg& c) {
+    uint64_t step = 1;      // bytes between variables
+
+    vaddr.resize(nvar);
+    vlen.assign(nvar, 1);
+
+    switch (c.layout) {
+        case PADDED:
+            step = CACHE_LINE;
+            break;
+
+        case PAGE:
+            step = sysconf(_SC_PAGESIZE);
+            break;
+
+        case POW2:
+            // Round up, so that addresses collide on any power-of-two hash
+            while (step < c.stride) {
+                step <<= 1;
+            }
+            break;
+
+        case REGION:
+            step = std::max(c.region, (uint32_t)1);
+            break;
+
+        default:
+            break;
+    }
+
+    /* Payloads are held by the variables themselves, in whole words */
+    uint64_t pay = (c.payload + 7) / 8 * 8;
+
+    if (pay > 0) {
+        if (c.layout == POW2) {
+            while (step < pay) {
+                step <<= 1;
+            }
+        } else if (c.layout == REGION) {
+            // Every region holds at least the payload
+            step = (std::max(step, pay) + 7) / 8 * 8;
+        } else {
+            step = (pay + step - 1) / step * step;
+        }
+
+        if (c.layout != REGION) {
+            vlen.assign(nvar, pay);
+        }
+    }
+
+    /* Scattered variables are spread over a mapping sparse enough to miss each
+     * other's lines and pages, but twice as large as them at least */
+    uint64_t unit = std::max(pay, (uint64_t)8);
+
+    varmap_s = c.layout == SCATTER ?
+               std::max(std::min((uint64_t)nvar * unit * SCATTER_SPARSE,
+                                 (uint64_t)SCATTER_SPAN),
+                        (uint64_t)nvar * unit * 2) :
+               std::max((uint64_t)nvar * step, (uint64_t)1);
+
+    // Only pages actually touched are ever backed by memory
+    varmap = (char*)mmap(NULL, varmap_s, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (varmap == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] Couldn't map %llu bytes for variables.\n",
+                (unsigned long long)varmap_s);
+
+        throw std::bad_alloc();
+    }
+
+    std::mt19937 gen(rand());
+
+    if (c.layout == SCATTER) {
+        /* Distinct, word aligned, offsets all over the mapping */
+        std::uniform_int_distribution<uint64_t> off(0, varmap_s / unit - 1);
+        std::unordered_set<uint64_t>            used;
+
+        for (uint32_t v = 0; v < nvar; v++) {
+            uint64_t o;
+
+            do {
+                o = off(gen);
+            } while (!used.insert(o).second);
+
+            vaddr[v] = (kmp_intptr)(varmap + o * unit);
+        }
+    } else if (c.layout == REGION) {
+        /* Contiguous regions of random length */
+        std::uniform_int_distribution<uint32_t> len(std::max(pay, (uint64_t)1),
+                                                    step);
+        uint64_t                                o = 0;
+
+        for (uint32_t v = 0; v < nvar; v++) {
+            vlen[v]  = pay > 0 ? (len(gen) + 7) / 8 * 8 : len(gen);
+            vaddr[v] = (kmp_intptr)(varmap + o);
+            o       += vlen[v];
+        }
+    } else {
+        for (uint32_t v = 0; v < nvar; v++) {
+            vaddr[v] = (kmp_intptr)(varmap + v * step);
+        }
+    }
+}
+
+void TaskLab::dispatch_plan::reset_payloads() {
+    for (uint32_t i = 0; i < ntasks; i++) {
+        for (uint32_t w = 0; w < params[i].wr_s; w++) {
+            memset(params[i].wr[w].buf, 0,
+                   params[i].wr[w].n * sizeof(uint64_t));
+        }
+    }
+}
+
+TaskLab::dispatch_plan::~dispatch_plan() {
+    free(dep_chk);
+    munmap(varmap, varmap_s);
+    delete[] params;
+    delete[] t_arr;
+    delete[] t_sub;
+    delete[] t_beg;
+    delete[] t_end;
+    delete[] t_thr;
+    delete[] t_ctr;
+    delete[] r_left;
+    delete[] chk_pool;
+    delete[] dep_pool;
+    delete[] acc_pool;
+    delete[] dep_list;
+    delete[] dep_n;
+}
+
+/* ************************
+ * Run of a graph
+ * ************************ */
+TaskLab::tenant_state::tenant_state(TaskGraph* g, plan_t* p, const rcfg& c)
+    : tg(g), pl(p), cfg(c), ps(NULL), ss(NULL), pc(NULL), shared(false),
+      error(false), left(0),
+      t_done(0), fl_tasks(0), fl_deps(0), fl_stall(0), fl_nstall(0) {
+    // Streamed graphs have no plan
+    if (pl == NULL) {
+        return;
+    }
+
+    /* Reset validation flags and payloads, since the plan is reused */
+    memset(pl->dep_chk, false, pl->nchk * sizeof(bool));
+    pl->reset_payloads();
+
+    // Events of every replay of a task add up
+    for (uint64_t i = 0; i < (uint64_t)NCTR * pl->ntasks; i++) {
+        pl->t_ctr[i] = 0;
+    }
+
+    /* Replays are told apart by their no. of unfinished tasks */
+    delete[] pl->r_left;
+
+    pl->r_left = new std::atomic<uint32_t>[cfg.iters];
+
+    pl->r_sub.assign(cfg.iters, 0);
+    pl->r_end.assign(cfg.iters, 0);
+
+    for (uint32_t i = 0; i < cfg.iters; i++) {
+        pl->r_left[i] = pl->ntasks;
+    }
+
+    left      = (uint64_t)pl->ntasks * cfg.iters;
+    pl->t_run = stamp();
+}
+
+bool TaskLab::load_curve(const uint8_t rt, const float max_r,
+                         const uint32_t steps) {
+    rcfg                 prev = cfg;
+    std::vector<lstat_t> res;
+    bool                 ok   = true;
+
+    if (max_r <= 0 || steps == 0) {
+        fprintf(stderr, "[ERROR] Invalid offered loads.\n");
+
+        return false;
+    }
+
+    if (cfg.arrival == Arrival::CLOSED) {
+        cfg.arrival = Arrival::POISSON;
+    }
+
+    for (uint32_t k = 1; k <= steps; k++) {
+        cfg.rate = max_r * k / steps;
+
+        printf("--- Offered load: %.0f tasks/s\n", cfg.rate);
+
+        ok = run(rt) && ok;
+
+        res.push_back(ol);
+    }
+
+    cfg = prev;
+
+    printf("--- Load-latency curve (us)\n");
+    printf("\t\t%12s %12s %10s %10s %10s\n", "offered", "achieved", "p50",
+           "p99", "p999");
+
+    for (size_t k = 0; k < res.size(); k++) {
+        printf("\t\t%12.0f %12.0f %10.2f %10.2f %10.2f\n", res[k].offered,
+               res[k].achieved, res[k].p50 / 1e3, res[k].p99 / 1e3,
+               res[k].p999 / 1e3);
+    }
+
+    return ok;
+}
+
+TaskLab::plan_t* TaskLab::claim(const rcfg& c) {
+    std::lock_guard<std::mutex> l(r_lock);
+
+    if (!prepare()) {
+        return NULL;
+    }
+
+    // Runs alongside another one of the same graph get a plan of their own
+    plan_t* p = pl->busy ? new plan_t(tg, c) : pl;
+
+    p->busy = true;
+
+    return p;
+}
+
+void TaskLab::release(plan_t* p) {
+    std::lock_guard<std::mutex> l(r_lock);
+
+    if (p == pl) {
+        pl->busy = false;
+    } else {
+        delete p;
+    }
+}
+
+bool TaskLab::prepare() {
+    /* Check if there is a high task graph available to be dispatched */
+    if (empty(HTASK)) {
+        fprintf(stderr, "[ERROR] There isn't any graph to be dispatched!\n");
+
+        return false;
+    }
+
+    if (pl == NULL) {
+        pl = new plan_t(tg, cfg);
+    }
+
+    return true;
+}
+
+void TaskLab::configure(const rcfg& c) {
+    // Plans hold the addresses of variables
+    if (c.layout != cfg.layout || c.stride != cfg.stride ||
+        c.region != cfg.region || c.payload != cfg.payload ||
+        c.kernel != cfg.kernel) {
+        invalidate();
+    }
+
+    cfg = c;
+
+    // Open loop needs a load to offer
+    if (cfg.arrival != Arrival::CLOSED && cfg.rate <= 0) {
+        fprintf(stderr, "[WARNING] Open-loop arrival needs a positive rate, \
+submitting as fast as possible.\n");
+
+        cfg.arrival = Arrival::CLOSED;
+    }
+
+    // Replays are submitted in graph order by a single thread
+    if (cfg.iters == 0) {
+        cfg.iters = 1;
+    }
+
+    if (cfg.iters > 1 && (cfg.dispatch != Dispatch::SERIAL ||
+                          cfg.arrival != Arrival::CLOSED)) {
+        fprintf(stderr, "[WARNING] Replays need serial, closed-loop dispatch, \
+running the graph once.\n");
+
+        cfg.iters = 1;
+    }
+
+    std::vector<int> ids;
+
+    if (cfg.affinity == Affinity::CPUS && !cpu_list(cfg.cpus.c_str(), ids)) {
+        fprintf(stderr, "[WARNING] Invalid list of CPUs \"%s\", threads are \
+not pinned.\n", cfg.cpus.c_str());
+
+        cfg.affinity = Affinity::FREE;
+    }
+
+    ids = numa_nodes();
+
+    if (cfg.placement == Placement::BIND &&
+        std::find(ids.begin(), ids.end(), (int)cfg.node) == ids.end()) {
+        fprintf(stderr, "[WARNING] There is no NUMA node %u, variables are left \
+where they are.\n", cfg.node);
+
+        cfg.placement = Placement::LEAVE;
+    }
+}
+
+const rcfg& TaskLab::config() {
+    return cfg;
 }
 
-TaskLab::~TaskLab() {
-    if (tg != NULL) {
-        delete tg;
+void TaskLab::invalidate() {
+    std::lock_guard<std::mutex> l(r_lock);
+
+    // A plan in use is left to its run, which deletes it once released
+    if (pl != NULL && !pl->busy) {
+        delete pl;
     }
+
+    pl = NULL;
 }
 
 /* ************************
  * Dispatcher handlers
  * ************************ */
 bool TaskLab::init_run(const uint8_t rt) {
+    /* Symbols of a runtime are resolved only once, even by concurrent runs */
+    static uint8_t    resolved = 0;
+    static std::mutex lock;
+
+    std::lock_guard<std::mutex> l(lock);
+
+    if (rt == resolved) {
+        return true;
+    }
+
     /* Get function pointer from according runtime */
     if (rt == RT::MTSP) {
         fork_call          = (fc_t)dlsym(RTLD_NEXT, "__kmpc_fork_call");
         omp_task_alloc     = (ta_t)dlsym(RTLD_NEXT, "__kmpc_omp_task_alloc");
         omp_task_with_deps = (td_t)dlsym(RTLD_NEXT, "__kmpc_omp_task_with_deps");
         omp_taskwait       = (tw_t)dlsym(RTLD_NEXT, "__kmpc_omp_taskwait");
+        // Optional, the team size is guessed otherwise (see team_size)
+        omp_max_threads    = (mt_t)dlsym(RTLD_NEXT, "omp_get_max_threads");
 #ifdef TIOGA
         pretty_dump        = (tp_t)dlsym(RTLD_NEXT, "pretty_dump");
 #endif
@@ -812,165 +2287,564 @@ bool TaskLab::init_run(const uint8_t rt) {
         }
 #endif
         /* Good to go! */
+        resolved = rt;
+
         return true;
     }
 }
 
 
-void TaskLab::microtask(int gid, int tid, void* param) {
-    /* Variables that keep in track with the digraph 
-     * workflow when dispatching */
-    bool*      dep_chk; /* Dependency validation (task graph) */
+uint32_t TaskLab::team_size() {
+    if (omp_max_threads != NULL) {
+        return omp_max_threads();
+    }
+
+    const char* env = getenv("OMP_NUM_THREADS");
+
+    if (env != NULL && atoi(env) > 0) {
+        return atoi(env);
+    }
+
+    return std::thread::hardware_concurrency();
+}
+
+void TaskLab::settle(rcfg& c, const plan_t* p, const uint8_t rt) {
+    /* Producers besides the dispatcher are tasks, and the tasks they create
+     * are their children: edges between tasks of different producers are
+     * only ordered by a runtime with a single dependency table for every
+     * task, whatever its parent (MTSP), rather than among siblings (OpenMP) */
+    if (c.dispatch != Dispatch::SERIAL && rt != RT::MTSP) {
+        fprintf(stderr, "[WARNING] Only MTSP orders dependencies across \
+producers, dispatching from a single thread.\n");
+
+        c.dispatch = Dispatch::SERIAL;
+    }
+
+    // Producers stalled on a full window must leave threads to drain it
+    uint32_t nthr = std::max(team_size(), 2u);
+
+    if (throttled(c) && c.dispatch != Dispatch::SERIAL && c.producers >= nthr) {
+        fprintf(stderr, "[WARNING] An in-flight window needs threads besides \
+producers, using %u producers.\n", nthr - 1);
+
+        c.producers = nthr - 1;
+    }
+
+    /* Nested tasks are spawned by their parents, neither by producers nor
+     * following an arrival process */
+    if (p->nested && c.dispatch != Dispatch::SERIAL) {
+        fprintf(stderr, "[WARNING] Nested graphs are dispatched by a single \
+thread.\n");
+
+        c.dispatch = Dispatch::SERIAL;
+    }
+
+    if (p->nested && c.arrival != Arrival::CLOSED) {
+        fprintf(stderr, "[WARNING] Nested graphs are dispatched in closed \
+loop.\n");
+
+        c.arrival = Arrival::CLOSED;
+    }
 
-    bool*      varptr;  /* Pointer for variables addresses */
-    tparam_t*  params;  /* Our own param. manager, will be 
-                         * initialized later on */
+    // Only direct children are waited for between replays
+    if (p->nested && !p->joined && c.iters > 1 && !c.overlap) {
+        fprintf(stderr, "[WARNING] Replays of a nested graph whose tasks do not \
+wait for their children overlap.\n");
 
-    dep_chk = new bool[tg_t->ndeps];
-    varptr  = new bool[tg_t->nvar];
-    params  = new tparam_t[tg_t->ntasks]; 
+        c.overlap = true;
+    }
+
+    // Overlapped replays would set each other's validation flags
+    if (c.overlap && c.iters > 1 && c.validate) {
+        fprintf(stderr, "[WARNING] Overlapped replays can't be validated, running \
+without validation.\n");
+
+        c.validate = false;
+    }
+}
+
+bool TaskLab::report(tenant_t& tn) {
+    const rcfg& cfg = tn.cfg;
+
+    if (throttled(cfg)) {
+        printf("\tIn-flight window: %u tasks, %u dependencies (0 is unbounded), \
+stalled %.3f ms over %llu submissions\n", cfg.max_tasks, cfg.max_deps,
+               tn.fl_stall / 1e6, (unsigned long long)tn.fl_nstall.load());
+    }
+
+    if (cfg.iters > 1) {
+        replays(tn);
+    }
+
+    /* Predecessor flags only tell children ran after parents */
+    if (cfg.validate && !check_order(tn)) {
+        tn.error = true;
+    }
+
+    if (timed(cfg)) {
+        latency(tn);
+    }
+
+    if (cfg.arrival != Arrival::CLOSED) {
+        lstat_t o = open_loop(tn);
+
+        std::lock_guard<std::mutex> l(r_lock);
 
-    memset(dep_chk, false, tg_t->ndeps * sizeof(bool));
-    memset(varptr, false, tg_t->nvar * sizeof(bool));
+        ol = o;
+    }
+
+    if (cfg.analyze) {
+        lost_parallelism(tn);
+    }
+
+    /* Was the execution successful? */
+    if (tn.error) {
+        printf("[ERROR] The graph did not executed correctly!\n");
+
+        return false;
+    } else {
+        /* Everything went fine! */
+        return true;
+    }
+}
+
+void TaskLab::microtask(int gid, int tid, void* param) {
+    region_t*               rg = (region_t*) param;
+    std::vector<tenant_t*>& tn = rg->tn;
 
     #ifdef DEBUG
-    printf("Number of dependencies:\t %d\n", tg_t->ndeps);
-    printf("Number of variables:\t %d\n", tg_t->nvar);
-    printf("Number of tasks:\t %d\n", tg_t->ntasks);
+    printf("Number of dependencies:\t %d\n", tn[0]->tg->ndeps);
+    printf("Number of variables:\t %d\n", tn[0]->tg->nvar);
+    printf("Number of tasks:\t %d\n", tn[0]->tg->ntasks);
     #endif
 
+    // Workers count from region entry, not from their first task
+    if (tn[0]->cfg.counters) {
+        ctr_team(0);
+    }
+
     std::cout << "Start Dispatching tasks!\n";
 
-    // Since a task only depends on the previous tasks (in the vector index), a
-    // valid approach is to dispatch the tasks in the vector order
-    std::vector<_task>::iterator it;
-    for (it = tg_t->tasks.begin(); it != tg_t->tasks.end(); ++it) {
-        kmp_depend_info*          dep_list;
-        kmp_task*                 task;
-        std::list<_dep>::iterator itt;
+    if (tn.size() > 1 && rg->mix == Mix::INTERLEAVED) {
+        interleave(rg, 0);
+    } else {
+        /* Every graph but the first is dispatched by a producer of its own */
+        for (size_t k = 1; k < tn.size(); k++) {
+            kmp_task* task = (kmp_task*)omp_task_alloc(NULL, 0, 0,
+                                                       sizeof(kmp_task) + sizeof(tpriv_t), 0,
+                                                       (kmp_routine_entry)tenant_f);
+            tpriv_t*  v    = (tpriv_t*)(task + 1);
 
-        uint cur_pred, cur_succ;     // Counter for predecessors and successors
-        uint n_dep;                  // Total number for dependencies
+            v->tn = tn[k];
+            v->it = 0;
 
-        uint32_t cur_task = it->tID; // Task id
+            omp_task_with_deps(NULL, 0, task, 0, NULL, 0, NULL);
+        }
 
-        /* Initialize task structure */
-        task = (kmp_task*)omp_task_alloc(NULL, 0, 0, sizeof(kmp_task) + 8, 0,
-                                         (kmp_routine_entry)ptask_f);
+        dispatch(tn[0], 0);
+    }
 
-        // -- Set configurations regarding task
+    std::cout << "\tDone Dispatching!\n";
 
-        /* Compute number of dependencies for current task */
-        params[cur_task].pred_s = it->predecessors.size();
-        params[cur_task].succ_s = it->successors.size();
+    // Wait until all tasks have been executed: producers wait for the tasks
+    // they created before finishing
+    omp_taskwait(nullptr, 0);
 
-        #ifdef DEBUG
-        printf("-- Task no.%d has %d predecessors and %d successors --\n\n", it->tID,
-               params[cur_task].pred_s, params[cur_task].succ_s);
-        #endif
+    std::cout << "\tDone executing!\n";
 
-        // -- Set our own data regarding task graph verification
-        params[cur_task].tID  = cur_task;
-        params[cur_task].exec = it->exec;
+    /* Report creation rate */
+    for (size_t g = 0; g < tn.size(); g++) {
+        pstate_t* ps = tn[g]->ps;
 
-        params[cur_task].pred = new bool*[params[cur_task].pred_s];
-        params[cur_task].succ = new bool*[params[cur_task].succ_s];
+        if (ps == NULL) {
+            continue;
+        }
 
-        /* Pointer to our params indexes */
-        cur_pred = cur_succ = 0;
+        uint32_t nprod = ps->ids.size();
+        double   first = -1, last = 0;
+        uint64_t total = 0;
 
-        /* Total of dependecies relying on different variables from current task */
-        n_dep = params[cur_task].succ_s;
+        for (uint32_t k = 0; k < nprod; k++) {
+            if (ps->count[k] == 0) {
+                continue;
+            }
 
-        /* Initialize dep_list to dispatch it to runtime */
-        dep_list = new kmp_depend_info[n_dep + 1];
+            first  = first < 0 ? ps->begin[k] : std::min(first, ps->begin[k]);
+            last   = std::max(last, ps->end[k]);
+            total += ps->count[k];
+        }
 
-        /* Set first position which will be used as pointer ref. */
-        dep_list[0].base_addr = (kmp_intptr) &(params[cur_task]);
-        dep_list[0].len       = sizeof(params[cur_task]);
-        dep_list[0].flags.in  = true;       // technically, this variable
-                                            // is read at the function
-        dep_list[0].flags.out = false;
+        if (tn.size() > 1) {
+            printf("\tGraph %zu:\n", g);
+        }
 
-        /* Pointer to our dep_list indexes */
-        uint32_t i = 1;
+        printf("\tProducers: %u (%s), creation rate: %.0f tasks/s\n", nprod,
+               tn[g]->cfg.dispatch == Dispatch::LEVEL ? "by level" : "by range",
+               last > first ? total / (last - first) : 0);
 
-        // -- Describe dependencies that will be dispatched
-        for (itt = it->successors.begin(); itt != it->successors.end(); ++itt) {
-            // -- Describe dep_list
-            /* Address to rely on */
-            dep_list[i].base_addr = (kmp_intptr) &varptr[itt->var];
-            dep_list[i].len = sizeof(varptr[itt->var]);
+        for (uint32_t k = 0; k < nprod; k++) {
+            printf("\t\tproducer %u: %lu tasks, %.0f tasks/s\n", k,
+                   (unsigned long)ps->count[k], ps->end[k] > ps->begin[k] ?
+                   ps->count[k] / (ps->end[k] - ps->begin[k]) : 0);
+        }
+
+        delete[] ps->lvl_sub;
+        delete[] ps->sub;
+        delete ps;
+
+        tn[g]->ps = NULL;
+    }
+}
+
+void TaskLab::dispatch(tenant_t* tn, kmp_int32 gtid) {
+    plan_t*     pl  = tn->pl;
+    const rcfg& cfg = tn->cfg;
+
+    if (cfg.dispatch == Dispatch::SERIAL || cfg.arrival != Arrival::CLOSED) {
+        /* Open loop: tasks are due following the arrival process, no matter
+         * how fast the runtime takes them */
+        uint32_t     burst = cfg.arrival == Arrival::BURSTY ?
+                             std::max(cfg.burst, (uint32_t)1) : 1;
+        std::mt19937 gen(rand());
+        std::exponential_distribution<double> gap(cfg.rate / burst);
+        uint64_t     due   = stamp();
+
+        for (uint32_t it = 0; it < cfg.iters; it++) {
+            pl->r_sub[it] = stamp();
+
+            // Since a task only depends on the previous tasks (in the
+            // vector index), a valid approach is to dispatch the tasks in
+            // the vector order
+            for (uint32_t cur_task = 0; cur_task < pl->ntasks; cur_task++) {
+                // Nested tasks are spawned by their parents
+                if (pl->params[cur_task].parent != (uint32_t)NONE) {
+                    continue;
+                }
+
+                if (cfg.arrival != Arrival::CLOSED) {
+                    if (cur_task > 0 && cur_task % burst == 0) {
+                        due += cfg.arrival == Arrival::CONSTANT ?
+                               1e9 / cfg.rate : gap(gen) * 1e9;
+                    }
+
+                    pl->t_arr[cur_task] = due;
+
+                    // Sleeping is far too coarse for the rates of interest
+                    while (stamp() < due);
+                }
+
+                if (throttled(cfg)) {
+                    admit(tn, cur_task);
+                }
+
+                submit(tn, gtid, cur_task, it);
+            }
+
+            /* Without overlap, a replay starts once the previous one is done,
+             * and validates its dependencies (and payloads) anew */
+            if (!cfg.overlap && it + 1 < cfg.iters) {
+                omp_taskwait(nullptr, gtid);
+
+                memset(pl->dep_chk, false, pl->nchk * sizeof(bool));
+                pl->reset_payloads();
+            }
+        }
+
+        return;
+    }
 
-            /* Dependency type */
-            dep_list[i].flags.in = (itt->type != Type::OUT) ? true : false;
-            dep_list[i].flags.out = (itt->type != Type::IN) ? true : false;
+    /* -- Multi-producer dispatch */
+    uint32_t  nprod = std::max(cfg.producers, (uint32_t)1);
+    uint32_t  nlvl  = pl->lvl.size() - 1;
+    pstate_t* ps    = new pstate_t();
 
-            ++i;
+    ps->next    = 0;
+    ps->lvl_sub = new std::atomic<uint32_t>[nlvl];
+    ps->sub     = new std::atomic<bool>[pl->ntasks];
 
-            // -- Dependency validation pointer
-            params[cur_task].succ[cur_succ] = &dep_chk[itt->dID];
-            ++cur_succ;
+    for (uint32_t l = 0; l < nlvl; l++) {
+        ps->lvl_sub[l] = 0;
+    }
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        ps->sub[t] = false;
+    }
+
+    for (uint32_t k = 0; k < nprod; k++) {
+        ps->ids.push_back(k);
+    }
+
+    /* Chunks of each level, which never cross levels */
+    if (cfg.dispatch == Dispatch::LEVEL) {
+        uint32_t chunk = std::max(cfg.chunk, (uint32_t)1);
+
+        for (uint32_t l = 0; l < nlvl; l++) {
+            for (uint32_t i = pl->lvl[l]; i < pl->lvl[l + 1]; i += chunk) {
+                ps->cbeg.push_back(i);
+                ps->clvl.push_back(l);
+            }
         }
 
-        // -- Set our own verifier
-        for (itt = it->predecessors.begin(); itt != it->predecessors.end(); ++itt) {
-            // -- Dependency validation pointer
-            params[cur_task].pred[cur_pred] = &dep_chk[itt->dID];
-            ++cur_pred;
+        ps->cbeg.push_back(pl->ntasks);
+    }
+
+    ps->count.assign(nprod, 0);
+    ps->begin.assign(nprod, 0);
+    ps->end.assign(nprod, 0);
+
+    tn->ps = ps;
+
+    /* Every producer but the current thread is a task of its own */
+    std::vector<kmp_depend_info> prod_dep(nprod);
+
+    for (uint32_t k = 1; k < nprod; k++) {
+        kmp_task* task = (kmp_task*)omp_task_alloc(NULL, gtid, 0,
+                                                   sizeof(kmp_task) + sizeof(tpriv_t), 0,
+                                                   (kmp_routine_entry)producer_f);
+        tpriv_t*  v    = (tpriv_t*)(task + 1);
+
+        v->tn = tn;
+        v->it = 0;
+
+        prod_dep[k].base_addr = (kmp_intptr) &ps->ids[k];
+        prod_dep[k].len       = sizeof(ps->ids[k]);
+        prod_dep[k].flags.in  = true;
+        prod_dep[k].flags.out = false;
+
+        omp_task_with_deps(NULL, gtid, task, 1, &prod_dep[k], 0, NULL);
+    }
+
+    produce(tn, gtid, 0);
+}
+
+void TaskLab::interleave(region_t* rg, kmp_int32 gtid) {
+    std::vector<tenant_t*>& tn = rg->tn;
+    std::vector<uint32_t>   next(tn.size(), 0);    // next task of each graph
+    size_t                  left = tn.size();      // graphs not done yet
+
+    for (size_t k = 0; k < tn.size(); k++) {
+        tn[k]->pl->r_sub[0] = stamp();
+    }
+
+    // Graphs take turns, a task at a time
+    while (left > 0) {
+        for (size_t k = 0; k < tn.size(); k++) {
+            plan_t*   pl  = tn[k]->pl;
+            uint32_t& cur = next[k];
+
+            if (cur == pl->ntasks) {
+                continue;
+            }
+
+            if (throttled(tn[k]->cfg)) {
+                admit(tn[k], cur);
+            }
+
+            submit(tn[k], gtid, cur, 0);
+
+            // Nested tasks are spawned by their parents
+            do {
+                ++cur;
+            } while (cur < pl->ntasks && pl->params[cur].parent != (uint32_t)NONE);
+
+            left -= cur == pl->ntasks;
         }
+    }
+}
+
+void TaskLab::submit(tenant_t* tn, kmp_int32 gtid, uint32_t cur_task,
+                     uint32_t it) {
+    plan_t* pl = tn->pl;
+
+    /* Initialize task structure */
+    kmp_task* task = (kmp_task*)omp_task_alloc(NULL, gtid, 0,
+                                               sizeof(kmp_task) + sizeof(tpriv_t), 0,
+                                               (kmp_routine_entry)ptask_f);
+    tpriv_t*  v    = (tpriv_t*)(task + 1);
+
+    // Graph and replay of the task, on its private data
+    v->tn = tn;
+    v->it = it;
 
 #ifdef DEBUG
-        /* Finally, dispatch task! */
-        std::cout << "\tdispatching task " << cur_task << "\n";
+    /* Finally, dispatch task! */
+    std::cout << "\tdispatching task " << cur_task << "\n";
 #endif
 
-		omp_task_with_deps(NULL, 0, task, n_dep + 1, dep_list, 0, NULL);
-
-        /* Clean up the mess */
-        delete dep_list;
+    // The timeline is the one of the last replay
+    if (timed(tn->cfg) && it + 1 == tn->cfg.iters) {
+        pl->t_sub[cur_task] = stamp();
     }
 
-    std::cout << "\tDone Dispatching!\n";
+    omp_task_with_deps(NULL, gtid, task, pl->dep_n[cur_task],
+                       pl->dep_list[cur_task], 0, NULL);
+}
 
-    // Wait until all tasks have been executed
-    omp_taskwait(nullptr, 0);
+void TaskLab::tenant_f(kmp_int32 gtid, void* param) {
+    kmp_task* t = (kmp_task*) param;
+    tpriv_t*  v = (tpriv_t*)(t + 1);
 
-    std::cout << "\tDone executing!\n";
+    place(v->tn->pc, gtid);
+
+    dispatch(v->tn, gtid);
+
+    // Its tasks are its children, which the region waits for through it
+    omp_taskwait(NULL, gtid);
+}
+
+void TaskLab::produce(tenant_t* tn, kmp_int32 gtid, uint32_t id) {
+    pstate_t*   ps    = tn->ps;
+    plan_t*     pl    = tn->pl;
+    const rcfg& cfg   = tn->cfg;
+    uint32_t    chunk = std::max(cfg.chunk, (uint32_t)1);
+    uint64_t  count = 0;
+
+    ps->begin[id] = now();
+
+    while (true) {
+        uint64_t c = ps->next++;    // claimed chunk
+        uint32_t from, to, l = 0;
+
+        if (cfg.dispatch == Dispatch::LEVEL) {
+            if (c + 1 >= ps->cbeg.size()) {
+                break;
+            }
+
+            l    = ps->clvl[c];
+            from = ps->cbeg[c];
+            to   = ps->cbeg[c + 1];
+
+            // The whole previous level must have been submitted
+            if (l > 0) {
+                uint32_t width = pl->lvl[l] - pl->lvl[l - 1];
+
+                while (ps->lvl_sub[l - 1].load(std::memory_order_acquire) < width) {
+                    std::this_thread::yield();
+                }
+            }
+        } else {
+            if (c * chunk >= pl->ntasks) {
+                break;
+            }
+
+            from = c * chunk;
+            to   = std::min(from + chunk, pl->ntasks);
+        }
+
+        for (uint32_t i = from; i < to; i++) {
+            uint32_t cur_task = cfg.dispatch == Dispatch::LEVEL ?
+                                pl->order[i] : i;
+
+            // Predecessors must have been submitted before the task
+            if (cfg.dispatch == Dispatch::RANGE) {
+                for (uint32_t j = pl->pt_off[cur_task];
+                     j < pl->pt_off[cur_task + 1]; j++) {
+                    while (!ps->sub[pl->pt[j]].load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            if (throttled(cfg)) {
+                admit(tn, cur_task);
+            }
+
+            submit(tn, gtid, cur_task, 0);     // a single replay
 
-    /* Free memory */
-    for (it = tg_t->tasks.begin(); it != tg_t->tasks.end(); ++it) {
-        uint32_t cur_task = it->tID; // task id
+            ps->sub[cur_task].store(true, std::memory_order_release);
+        }
+
+        if (cfg.dispatch == Dispatch::LEVEL) {
+            ps->lvl_sub[l].fetch_add(to - from, std::memory_order_release);
+        }
 
-        delete params[cur_task].pred;
-        delete params[cur_task].succ;
+        count += to - from;
     }
 
-    delete dep_chk;
-    delete varptr;
-    delete params;
+    ps->end[id]   = now();
+    ps->count[id] = count;
+}
+
+void TaskLab::producer_f(kmp_int32 gtid, void* param) {
+    kmp_task* t = (kmp_task*) param;
+    mtsp_task_metadata* md = t->metadata;
+    tpriv_t*  v = (tpriv_t*)(t + 1);
+
+    /* --- get producer id! --- */
+    uint32_t* id = (uint32_t*) md->dep_list[0].base_addr;
+
+    place(v->tn->pc, gtid);
+
+    produce(v->tn, gtid, *id);
+
+    // Its tasks are its children, which the region waits for through it
+    omp_taskwait(NULL, gtid);
 }
 
-void TaskLab::f(tparam_t param) {
+void TaskLab::f(tenant_t* tn, tparam_t param) {
     bool cur = true;
 
     // Load time to be executed on the current task
-    int load = (param.exec * tg_t->exec_t) + tg_t->exec_t;
+    long load = (param.exec * tn->tg->exec_t) + tn->tg->exec_t;
 
-    int i, foo;
+    long i, foo;
 
     // Waiting!
     // std::this_thread::sleep_for(std::chrono::milliseconds(load));
 
     // do some arbitrary work for amount of load
-    for (i = 0, foo = 0; i < load; i++) {
-        foo++;
+    if (param.kern == Kernel::SPIN) {
+        for (i = 0, foo = 0; i < load; i++) {
+            foo++;
+        }
+    } else {
+        volatile uint64_t keep = kernel(param.kern, load, tn->cfg.wset);
+        (void)keep;
+    }
+
+    // -- Move the payloads: sum what is read, then stamp what is written
+    for (uint r = 0; r < param.rd_s; r++) {
+        const bacc_t& a   = param.rd[r];
+        uint64_t      sum = 0;
+
+        for (uint32_t w = 0; w < a.n; w++) {
+            sum += a.buf[w];
+        }
+
+        // Payloads are whole stamps of their last writer
+        if (tn->cfg.validate && sum != a.ver * a.n) {
+            std::string err_str;
+
+            err_str = "task " + std::to_string(param.tID) +
+                      " read a stale or torn payload\n";
+
+            tn->error = true;
+
+            std::cerr << err_str;
+        }
+
+        // Keep the reads, even if not checked
+        volatile uint64_t keep = sum;
+        (void)keep;
+    }
+
+    for (uint r = 0; r < param.wr_s; r++) {
+        const bacc_t& a = param.wr[r];
+
+        for (uint32_t w = 0; w < a.n; w++) {
+            a.buf[w] = a.ver;
+        }
     }
 
 #ifdef DEBUG
     printf("Executing task no. %d.\n", param.tID);
 #endif
 
+    // Throughput runs do not validate anything
+    if (!tn->cfg.validate) {
+        return;
+    }
+
     // -- Compute if task execution is valid --
 
     // Check if all input dependencies are true (if in_s is 0, then cur will
@@ -992,7 +2866,7 @@ void TaskLab::f(tparam_t param) {
         err_str = "invalid execution of task " + std::to_string(param.tID) + "\n";
 
         /* Error found */
-        r_error = true;
+        tn->error = true;
 
         std::cerr << err_str;
     }
@@ -1010,6 +2884,13 @@ void TaskLab::ptask_f(kmp_int32 gtid, void* param) {
     /* --- get param! --- */
     tparam_t* p = (tparam_t*) md->dep_list[0].base_addr;
 
+    /* --- its graph and replay! --- */
+    tpriv_t*    v   = (tpriv_t*)(t + 1);
+    tenant_t*   tn  = v->tn;
+    plan_t*     pl  = tn->pl;
+    const rcfg& cfg = tn->cfg;
+    uint32_t    it  = v->it;
+
 #ifdef DEBUG
 	printf("Executed with exec time no. %lf!\n", p->exec);
 
@@ -1018,12 +2899,161 @@ void TaskLab::ptask_f(kmp_int32 gtid, void* param) {
 #endif
 #endif
 
-    f(*p);
+    place(tn->pc, gtid);
+
+    std::atomic<uint64_t>* ctr = cfg.counters ? &pl->t_ctr[(size_t)NCTR * p->tID] :
+                                                NULL;
+    uint64_t               c0[NCTR], c1[NCTR];
+
+    if (ctr) {
+        ctr_read(gtid, c0);
+    }
+
+    // The timeline is the one of the last replay
+    if (timed(cfg) && it + 1 == cfg.iters) {
+        pl->t_beg[p->tID] = stamp();
+
+        f(tn, *p);
+
+        pl->t_end[p->tID] = stamp();
+        pl->t_thr[p->tID] = gtid;
+    } else {
+        f(tn, *p);
+    }
+
+    // Replays add up, and may run the same task at once (overlap)
+    if (ctr) {
+        ctr_read(gtid, c1);
+
+        for (int i = 0; i < NCTR; i++) {
+            ctr[i].fetch_add(c1[i] - c0[i], std::memory_order_relaxed);
+        }
+    }
+
+    /* Nested tasks are spawned once the work of their parent is done, on
+     * the same replay */
+    for (uint32_t k = 0; k < p->kids_s; k++) {
+        submit(tn, gtid, p->kids[k], it);
+    }
+
+    if (p->wait) {
+        omp_taskwait(NULL, gtid);
+    }
+
+    // The last task of a replay tells when it finished
+    if (cfg.iters > 1 &&
+        pl->r_left[it].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pl->r_end[it] = stamp();
+    }
+
+    // Leave the in-flight window, which only nested roots entered
+    if (throttled(cfg) && p->parent == (uint32_t)NONE) {
+        tn->fl_deps.fetch_sub(pl->dep_n[p->tID] - 1, std::memory_order_release);
+        tn->fl_tasks.fetch_sub(1, std::memory_order_release);
+    }
+
+    // The last task of a graph run alongside others tells when it finished
+    if (tn->shared && tn->left.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        tn->t_done = stamp();
+    }
+}
+
+void TaskLab::admit(tenant_t* tn, uint32_t cur_task) {
+    const rcfg& cfg   = tn->cfg;
+    uint32_t    nd    = tn->pl->dep_n[cur_task] - 1;
+    uint32_t    max_t = cfg.max_tasks ? cfg.max_tasks : (uint32_t)-1;
+    uint64_t    max_d = cfg.max_deps ? cfg.max_deps : (uint64_t)-1;
+    uint64_t    t0    = 0;
+
+    while (true) {
+        // Take the place, giving it back if it was not there; a task with
+        // more dependencies than the window still goes once it is empty
+        uint32_t t = tn->fl_tasks.fetch_add(1, std::memory_order_acquire);
+        uint64_t d = tn->fl_deps.fetch_add(nd, std::memory_order_acquire);
+
+        if (t < max_t && (d + nd <= max_d || d == 0)) {
+            break;
+        }
+
+        tn->fl_deps.fetch_sub(nd, std::memory_order_relaxed);
+        tn->fl_tasks.fetch_sub(1, std::memory_order_relaxed);
+
+        if (t0 == 0) {
+            t0 = stamp();
+        }
+
+        std::this_thread::yield();
+    }
+
+    if (t0 != 0) {
+        tn->fl_stall  += stamp() - t0;
+        tn->fl_nstall += 1;
+    }
+}
+
+bool TaskLab::throttled(const rcfg& c) {
+    return c.max_tasks != 0 || c.max_deps != 0;
 }
 
-/* Initialize static helper variables regarding dispatching */
-TaskGraph* TaskLab::tg_t = NULL;
-bool       TaskLab::r_error    = false;
+bool TaskLab::check_order(const tenant_t& tn) {
+    TaskGraph*    tg = tn.tg;
+    const plan_t* pl = tn.pl;
+
+    /* Per variable: its last writer, and the reader since then that finished
+     * last. Tasks are visited in ID order, so every access is seen once */
+    std::vector<uint32_t> lw(tg->nvar, (uint32_t)NONE);
+    std::vector<uint32_t> lr(tg->nvar, (uint32_t)NONE);
+    uint64_t              nviol = 0;
+
+    for (uint32_t t = 0; t < tg->ntasks; t++) {
+        std::list<_dep>::iterator it;
+        for (it = tg->tasks[t].successors.begin();
+             it != tg->tasks[t].successors.end(); ++it) {
+            uint32_t    v   = it->var;
+            uint32_t    o   = (uint32_t)NONE;   // task it should have waited for
+            const char* kind;
+
+            if (v >= tg->nvar) {
+                continue;
+            }
+
+            if (lw[v] != (uint32_t)NONE && lw[v] != t &&
+                pl->t_beg[t] < pl->t_end[lw[v]]) {
+                o    = lw[v];
+                kind = it->type == Type::IN ? "RAW" : "WAW";
+            } else if (it->type != Type::IN && lr[v] != (uint32_t)NONE &&
+                       lr[v] != t && pl->t_beg[t] < pl->t_end[lr[v]]) {
+                o    = lr[v];
+                kind = "WAR";
+            }
+
+            if (o != (uint32_t)NONE && nviol++ < MAX_VIOL) {
+                fprintf(stderr, "[ERROR] Task %u started before task %u finished (%s on variable %u).\n",
+                        t, o, kind, v);
+            }
+
+            if (it->type == Type::IN) {
+                if (lr[v] == (uint32_t)NONE || pl->t_end[t] > pl->t_end[lr[v]]) {
+                    lr[v] = t;
+                }
+            } else {
+                lw[v] = t;
+                lr[v] = (uint32_t)NONE;
+            }
+        }
+    }
+
+    if (nviol > MAX_VIOL) {
+        fprintf(stderr, "[ERROR] ... %llu ordering violations in total.\n",
+                (unsigned long long)nviol);
+    }
+
+    return nviol == 0;
+}
+
+bool TaskLab::timed(const rcfg& c) {
+    return c.validate || c.analyze || c.arrival != Arrival::CLOSED;
+}
 
 /* ************************
  * Helpers
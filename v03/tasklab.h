@@ -21,6 +21,7 @@
 
 #include <fstream>
 #include <string.h>
+#include <random>
 
 /* Serialization */
 #include <boost/archive/text_iarchive.hpp>
@@ -29,10 +30,13 @@
 #include <boost/serialization/vector.hpp> // vectors
 #include <boost/serialization/list.hpp>   // list
 #include <boost/serialization/map.hpp>    // map
+#include <boost/serialization/version.hpp>
 
 /* Dispatcher */
 #include <kmp.h>
 #include <thread>
+#include <atomic>
+#include <mutex>
 
 /* ***************
  * Default definitions
@@ -42,7 +46,51 @@
 #define DEFAULT_EXECUTION_RANGE (float)0.25        // max. range from standard load time (0 to 1)
 #define DEFAULT_NAME            (char*)"taskgraph" // default name for the graph
 
+#define DEFAULT_PARETO_SHAPE    (float)2.5         // Pareto tail index (alpha > 1)
+#define DEFAULT_BIMODAL_FRAC    (float)0.1         // fraction of long tasks on bimodal
+#define DEFAULT_BIMODAL_RATIO   (float)10          // long/short duration ratio on bimodal
+
 #define MAX_DOT_P               100                // max. no. of tasks by a plotted dot file
+#define CACHE_LINE              64                 // bytes of a cache line
+#define MAX_VIOL                10                 // max. no. of ordering violations printed
+#define DEFAULT_LAG             50                 // default late start threshold (us)
+#define MAX_LATE                10                 // max. no. of late tasks printed
+#define HIST_SUB                5                  // log2 of linear bins per power of two
+#define DEFAULT_BURST           16                 // default no. of tasks per burst
+#define DEFAULT_RATE            10000              // default offered load (tasks/s)
+#define DEFAULT_STRIDE          (1 << 16)          // default stride of POW2 layouts
+#define DEFAULT_REGION          256                // default max. length of REGION layouts
+#define SCATTER_SPAN            (1ull << 36)       // max. bytes mapped by SCATTER layouts
+#define SCATTER_SPARSE          512                // bytes mapped per byte of SCATTER variables
+#define DEFAULT_WSET            (32ull << 20)      // default memory per thread of kernels
+#define THRASH_SET              (4ull << 20)       // working set of THRASH (beyond L2)
+#define NCTR                    6                  // no. of hardware events counted
+#define CTR_JOIN                1000               // max. wait of the team joining the counters (us)
+#define MAX_PLACE_PAGES         4096               // max. no. of variable pages located
+#define MAX_NESTED              (uint32_t)16777216 // max. no. of tasks of a nested graph
+#define DEFAULT_FIB_CUTOFF      (uint32_t)10       // fib(k) below which tasks do not spawn
+#define DEFAULT_SORT_CUTOFF     (uint32_t)1024     // elements below which tasks do not spawn
+#define DEFAULT_BH_LEAF         (uint32_t)16       // max. no. of bodies of an octree leaf
+#define BH_MAX_DEPTH            21                 // max. depth of an octree
+
+/* Default dependency table of the simulated hardware */
+#define DEFAULT_SETS            64
+#define DEFAULT_WAYS            4
+#define DEFAULT_QUEUE           64
+#define DEFAULT_TDEPS           8
+#define DEFAULT_C_TASK          10
+#define DEFAULT_C_DEP           2
+#define PROFILE_BINS            64                 // no. of bins of profiled durations
+#define DEFAULT_TOLERANCE       (float)0.05        // accepted error on layered graph targets
+#define DEFAULT_WINDOW          (uint32_t)65536    // max. no. of in-flight tasks when streaming
+
+#define DEFAULT_CHUNK           (uint32_t)64       // tasks claimed at once by a producer
+
+#define BENCH_REPS              (uint32_t)10000    // default repetitions of each microbenchmark
+#define BENCH_BATCH             128                // max. no. of tasks in flight while benchmarking
+#define BENCH_MAX_DEPS          64                 // max. no. of dependencies of a benchmarked task
+
+#define STREAM_MAGIC            0x53474c54         // "TLGS", streamed graph file
 
 #define NONE                    -1
 
@@ -69,9 +117,56 @@ typedef enum Plot    { DOT = 1, LL = 2, INFO = 3 } Plot;
 /* Runtime definition */
 typedef enum Runtime { MTSP = 1 } RT;
 
+/* How tasks are created: by a single thread, or by several producers
+ * splitting the graph by topological level or by task range. Producers are
+ * tasks, so dependencies between tasks of different producers (which are not
+ * siblings) are only ordered by MTSP, whose dependency table holds every
+ * task */
+typedef enum Dispatch { SERIAL = 1, LEVEL = 2, RANGE = 3 } Dispatch;
+
+/* How several graphs run at once are submitted: taking turns, a task of each
+ * at a time, from a single thread, or each one by a producer of its own (a
+ * task waiting for the tasks of its graph, which share no variable with other
+ * graphs) */
+typedef enum Mix     { INTERLEAVED = 1, PER_PRODUCER = 2 } Mix;
+
+/* Where variables (i.e. dependency addresses) are placed: packed bytes, one
+ * per cache line, one per page, a power-of-two stride apart, at random over a
+ * mapping SCATTER_SPARSE times their size (up to SCATTER_SPAN) or as contiguous
+ * regions of random length (holding the payload at least) */
+typedef enum Layout  { DENSE = 1, PADDED = 2, PAGE = 3, POW2 = 4, SCATTER = 5,
+                       REGION = 6 } Layout;
+
+/* Work done by tasks: the original spin loop, vectorized FMAs, a STREAM
+ * triad, pointer chasing, a working set evicting L2, or any of them at random */
+typedef enum Kernel  { SPIN = 1, FMA = 2, TRIAD = 3, CHASE = 4, THRASH = 5,
+                       MIX = 6 } Kernel;
+
+/* Where threads run: wherever the OS puts them, packed on neighbouring
+ * cores, spread over sockets and cores, or on an explicit list of CPUs */
+typedef enum Affinity  { FREE = 1, COMPACT = 2, SPREAD = 3, CPUS = 4 } Affinity;
+
+/* Where variable memory lives: wherever it already is, on the node of the
+ * worker touching it first on every run, interleaved over nodes, or on one */
+typedef enum Placement { LEAVE = 1, TOUCH = 2, INTERLEAVE = 3, BIND = 4 } Placement;
+
+/* How open-loop submissions arrive (CLOSED submits as fast as possible) */
+typedef enum Arrival { CLOSED = 1, CONSTANT = 2, POISSON = 3, BURSTY = 4 } Arrival;
+
 /* Type of a dependency */
 typedef enum Type    { IN = 1, OUT = 2, INOUT = 3 } Type;
 
+/* Distribution of task durations on generated graphs */
+typedef enum Dist    { UNIFORM = 1, NORMAL = 2, LOGNORMAL = 3, EXPONENTIAL = 4,
+                       PARETO = 5, BIMODAL = 6, EMPIRICAL = 7 } Dist;
+
+/* Recursive shape of nested graphs: Fibonacci, quicksort and a Barnes-Hut
+ * octree, every task spawning the tasks of its subproblems */
+typedef enum Shape   { FIB = 1, QSORT = 2, BHTREE = 3 } Shape;
+
+/* Graph property that task durations may correlate with */
+typedef enum Corr    { FLAT = 0, NDEPS = 1, DEPTH = 2 } Corr;
+
 /* ***************
  * Task graph PUBLIC structure
  *   -- users should these structures
@@ -141,6 +236,9 @@ public:
     uint32_t npred;                // total number of predecessors
     float    exec;                 // how long should the task remain executing
 
+    uint32_t parent = (uint32_t)NONE;  // task spawning it (NONE: top level)
+    bool     wait   = false;           // whether it waits for its children
+
     /* ***************
      * Task structure handler
      * *************** */
@@ -150,6 +248,12 @@ public:
      * */
     bool hasdep(uint32_t ID);
 
+    /**
+     * Check if a given dep. is a predecessor of the task
+     * return:  true if dep. is a predecessor, otherwise false
+     * */
+    bool haspred(uint32_t ID);
+
 private:
     /* Serialization */
     friend class boost::serialization::access;
@@ -161,9 +265,124 @@ private:
         f & tID;
         f & npred;
         f & exec;
+
+        // Graphs saved before nesting are flat
+        if (version > 0) {
+            f & parent;
+            f & wait;
+        }
     }
 } _task;
 
+BOOST_CLASS_VERSION(_task, 1)
+
+/**
+ * dmodel describes how the duration of generated tasks is drawn. Every
+ * distribution is normalized to a mean of 1, i.e. of the standard execution
+ * size, so that graphs of different models carry the same total work (normal
+ * durations are truncated at 0, and scaled back to that mean).
+ */
+typedef struct duration_s {
+public:
+    uint8_t  dist;           // distribution of durations (see Dist)
+
+    float    spread;         // normal sd. or lognormal sigma (none: use max_r)
+    float    shape;          // Pareto tail index
+    float    frac;           // fraction of long tasks (bimodal)
+    float    ratio;          // long/short duration ratio (bimodal)
+
+    uint8_t  corr;           // graph property durations correlate with
+    float    weight;         // strength of the correlation (0 to 1)
+
+    /* Empirical histogram: bins [lo, hi), normalized by the histogram mean,
+     * and their cumulative weights */
+    std::vector<float> lo;
+    std::vector<float> hi;
+    std::vector<float> w;
+
+    duration_s();
+
+    /**
+     * Load an empirical histogram, one bin per line as "lo hi weight" in any
+     * unit of time ('#' starts a comment)
+     *  filename: name of the histogram file
+     *  return:   true if it succeeds, else false
+     */
+    bool load(const char* filename);
+
+    /**
+     * Draw a duration multiplier (mean 1) from the distribution
+     *  gen:   random engine
+     *  max_r: max. range from standard execution size (uniform/normal)
+     */
+    float sample(std::mt19937& gen, const float max_r);
+} dmodel;
+
+/**
+ * gprofile describes the statistics of a task graph, from which look-alike
+ * graphs of any size can be synthesized without the original graph
+ */
+typedef struct profile_s {
+public:
+    uint32_t ntasks;                       // no. of tasks of the profiled graph
+
+    std::vector<uint64_t> indeg;           // no. of tasks per no. of predecessors
+    std::vector<uint64_t> outdeg;          // no. of tasks per no. of children tasks
+    std::map<uint32_t, uint64_t> dist;     // no. of edges per predecessor distance
+    std::vector<uint64_t> mix;             // no. of edges per dependency type
+    std::vector<uint32_t> width;           // no. of tasks per level
+
+    /* Histogram of durations, in multiples of the standard execution size */
+    std::vector<float> dlo;
+    std::vector<float> dhi;
+    std::vector<float> dw;
+
+    uint32_t exec_t;                       // standard execution size
+
+    /**
+     * Print a summary of the profile
+     *  fd:    where to print
+     *  title: what is being summarized
+     */
+    void summary(FILE* fd, const char* title) const;
+
+private:
+    /* Serialization */
+    friend class boost::serialization::access;
+
+    template<class Archive>
+    void serialize(Archive &f, const uint version) {
+        f & ntasks;
+        f & indeg;
+        f & outdeg;
+        f & dist;
+        f & mix;
+        f & width;
+        f & dlo;
+        f & dhi;
+        f & dw;
+        f & exec_t;
+    }
+} gprofile;
+
+/**
+ * shead describes the header of a streamed graph (.sdat) file. It is followed
+ * by one record per task, in ID order:
+ *   float exec; uint32_t npred; npred * { uint32_t distance; uint8_t type; }
+ * Predecessors are the tasks "distance" IDs before, each one writing a new
+ * variable read (IN) or updated (INOUT) by the task, as in create_tasks.
+ */
+typedef struct stream_s {
+public:
+    uint32_t magic;          // STREAM_MAGIC
+    uint32_t ntasks;         // total number of tasks
+    uint64_t ndeps;          // total number of dependencies between tasks
+    uint32_t dep_r;          // max range of how far a predecessor may be
+    uint32_t max_dep;        // max. number of predecessors of a task
+    uint32_t exec_t;         // standard execution time per task (loop cycles)
+    float    max_r;          // max. range from standard execution time (0 to 1)
+} shead;
+
 /**
  * TaskGraph describes a complete graph of tasks
  */
@@ -192,6 +411,52 @@ public:
      * */
     void create_tasks(const uint32_t max_dep);
 
+    /**
+     * Feed the graph with tasks laid out in levels, every task of a level
+     * relying on at least one task of the previous level
+     *  nlvl:    number of levels
+     *  density: average no. of predecessors per task
+     *  widths:  relative width of each level (OPTIONAL, else even widths)
+     * */
+    void create_layers(const uint32_t nlvl, const float density,
+                       const std::vector<float>* widths = NULL);
+
+    /**
+     * Feed the graph with the recursion tree of a divide-and-conquer
+     * problem, where tasks are spawned by their parent (see nested.cpp)
+     *  shape:   recursive problem (see Shape)
+     *  n:       size of the problem (fib argument, elements or bodies)
+     *  cutoff:  size below which tasks solve their subproblem themselves
+     *  wait:    whether tasks wait for the tasks they spawn
+     *  return:  false if the tree would exceed MAX_NESTED tasks
+     * */
+    bool create_nested(const uint8_t shape, const uint32_t n,
+                       const uint32_t cutoff, const bool wait);
+
+    /**
+     * Check if the graph has tasks spawned by other tasks
+     *  return: true if any task has a parent
+     * */
+    bool nested();
+
+    /**
+     * Compute the critical path of the graph, weighted by task loads
+     *  return: length of the critical path (loop iterations)
+     * */
+    double span();
+
+    /**
+     * Compute the total load of the graph
+     *  return: sum of every task load (loop iterations)
+     * */
+    double work();
+
+    /**
+     * Set the model that create_tasks draws durations from
+     *  dm: duration model
+     * */
+    void set_duration(const dmodel& dm);
+
     /**
      * Describe dependency between tasks of the graph 
      *  task_id: id of the current task
@@ -202,6 +467,36 @@ public:
     void describe_deps(const uint32_t tID, uint32_t* dep_id, 
                        const uint32_t min, const uint32_t max);
 
+    /**
+     * Link a task to the predecessor already set on a dependency, with a
+     * new variable written by the predecessor
+     *  tID:    id of the current task
+     *  p:      predecessor dependency (task and type set)
+     *  dep_id: id of the next dependency
+     * */
+    void link(const uint32_t tID, _dep& p, uint32_t* dep_id);
+
+    /**
+     * Set load time of every task from the duration model
+     * */
+    void assign_durations();
+
+    /* ***************
+     * Profiling
+     * *************** */
+    /**
+     * Extract the statistics of the graph
+     *  p: profile to be filled
+     * */
+    void profile(gprofile& p);
+
+    /**
+     * Feed the graph with tasks matching the statistics of a profile
+     *  p:         profile to be matched
+     *  keep_span: scale the width of levels instead of their number
+     * */
+    void synthesize(const gprofile& p, const bool keep_span);
+
     /* ***************
      * Trace handlers
      * *************** */
@@ -227,6 +522,8 @@ private:
     uint32_t  exec_t;          // standard execution time per task (loop cycles)
     float     max_r;           // max. range from standard execution time (0 to 1)
 
+    dmodel    dur;             // duration model of generated tasks (not saved)
+
     /* Main dependency map with all variable addresses:
      *   each of them maps to a vector (or a single structure) with values 
      *   sufficient to describe a parent-children relationship.
@@ -257,6 +554,119 @@ private:
     }
 };
 
+/* ***************
+ * Run configuration
+ * *************** */
+/**
+ * rcfg describes how a graph is dispatched to the runtime
+ */
+typedef struct run_config {
+public:
+    uint8_t  dispatch;       // how tasks are created (see Dispatch)
+    uint32_t producers;      // no. of threads creating tasks (LEVEL/RANGE)
+    uint32_t chunk;          // no. of tasks claimed at once by a producer
+    bool     validate;       // whether tasks check dependencies were honored
+    bool     analyze;        // whether runs report lost parallelism
+    uint32_t lag;            // start lag (us) from which a task is late
+    uint8_t  arrival;        // how submissions are paced (see Arrival)
+    float    rate;           // offered load (tasks/s) of open-loop dispatch
+    uint32_t burst;          // no. of tasks arriving at once (BURSTY)
+    uint32_t max_tasks;      // max. no. of in-flight tasks (0 is unbounded)
+    uint32_t max_deps;       // max. no. of in-flight dependencies (0 is unbounded)
+    uint8_t  layout;         // where variables are placed (see Layout)
+    uint64_t stride;         // bytes between variables (POW2)
+    uint32_t region;         // max. length of a variable (REGION, >= payload)
+    uint32_t payload;        // bytes of data of every variable (0 is none)
+    uint8_t  kernel;         // work done by tasks (see Kernel)
+    uint64_t wset;           // bytes of memory of each thread (TRIAD, CHASE)
+    bool     counters;       // whether runs count hardware events (perf_event)
+    uint8_t  affinity;       // where threads run (see Affinity)
+    std::string cpus;        // CPUs of each thread, e.g. "0-3,8" (CPUS)
+    uint8_t  placement;      // where variables live (see Placement)
+    uint32_t node;           // NUMA node holding variables (BIND)
+    uint32_t iters;          // no. of times a run replays the graph
+    bool     overlap;        // whether replays overlap, else wait for each other
+
+    run_config();
+} rcfg;
+
+/**
+ * tcfg describes the dependency table and task queue of a hardware runtime,
+ * as modelled by TaskLab::simulate
+ */
+typedef struct table_config {
+public:
+    uint32_t sets;           // no. of sets of the dependency table
+    uint32_t ways;           // no. of entries (addresses) per set
+    uint32_t queue;          // no. of task queue entries
+    uint32_t max_deps;       // max. no. of dependencies per task
+    uint32_t workers;        // no. of workers running tasks
+    uint32_t c_task;         // cycles to submit a task
+    uint32_t c_dep;          // cycles to insert each of its dependencies
+    float    cpi;            // cycles per iteration of a task
+
+    table_config();
+} tcfg;
+
+/* ***************
+ * Task kernels
+ *   -- see kernels.cpp
+ * *************** */
+/**
+ * Kernel run by a given task
+ *  k:      kernel of the graph (see Kernel)
+ *  tID:    task id
+ *  return: the kernel of the task, MIX picking one per task
+ */
+uint8_t kernel_of(const uint8_t k, const uint32_t tID);
+
+/**
+ * Do some amount of work on the current thread
+ *  k:      kernel to be run (see Kernel, but SPIN and MIX)
+ *  load:   amount of work, i.e. iterations of the kernel
+ *  wset:   bytes of memory of the thread (TRIAD and CHASE)
+ *  return: a value depending on all the work, so that it is kept
+ */
+uint64_t kernel(const uint8_t k, const long load, const uint64_t wset);
+
+/* ***************
+ * Thread and memory placement
+ *   -- see placement.cpp
+ * *************** */
+/**
+ * Parse a list of CPUs (or nodes), e.g. "0-3,8,10"
+ *  s:      list to be parsed
+ *  cpus:   ids on the list, in order
+ *  return: if the list is valid and not empty
+ */
+bool cpu_list(const char* s, std::vector<int>& cpus);
+
+/**
+ * NUMA nodes of the machine
+ *  return: ids of the nodes online (a single node 0 if unknown)
+ */
+std::vector<int> numa_nodes();
+
+/* ***************
+ * Dispatch function symbols
+ *   -- resolved from the runtime by TaskLab::init_run
+ * *************** */
+typedef void  (*fc_t)(ident*, kmp_int32, kmpc_micro, ...);
+typedef void *(*ta_t)(ident*, kmp_int32, kmp_int32, kmp_uint32, kmp_uint32, kmp_routine_entry);
+typedef void  (*td_t)(ident*, kmp_int32, kmp_task*, kmp_int32, kmp_depend_info*, kmp_int32, kmp_depend_info*);
+typedef void  (*tw_t)(ident*, kmp_int32);
+typedef int   (*mt_t)();
+
+typedef void  (*tp_t)();
+
+extern fc_t fork_call;
+extern ta_t omp_task_alloc;
+extern td_t omp_task_with_deps;
+extern tw_t omp_taskwait;
+extern mt_t omp_max_threads;
+
+extern tp_t pretty_dump;
+
 /* ***************
  * TaskLab
  * *************** */
@@ -278,6 +688,57 @@ public:
                   const uint32_t d, const uint32_t t,
                   const float    r);
 
+    /*
+     * Generates a layered directed acyclic graph hitting target scheduling
+     * quantities, and reports the achieved ones
+     *  n       is the number of tasks to be generated;
+     *  w       is the total work, i.e. loop iterations of all tasks;
+     *  s       is the span, i.e. iterations along the critical path
+     *          (ignored if widths is given);
+     *  e       is the edge density, i.e. avg. no. of predecessors per task;
+     *  widths  is the relative width of each level (OPTIONAL).
+     *
+     *  returns if the targets were hit within DEFAULT_TOLERANCE
+     * */
+    bool layered(const uint32_t n, const double w, const double s,
+                 const float e, const std::vector<float>* widths = NULL);
+
+    /*
+     * Generates a nested graph, i.e. the recursion tree of a divide-and-
+     * conquer problem: only its root is created by the dispatcher, every
+     * other task is spawned by its parent once the parent's work is done
+     *  shape   is the recursive problem (see Shape);
+     *  n       is the size of the problem, i.e. the Fibonacci argument,
+     *          no. of elements to sort or no. of bodies;
+     *  cutoff  is the size below which tasks do not spawn any task;
+     *  wait    is whether tasks wait for the tasks they spawn (taskwait);
+     *  t       is the standard execution time per task (OPTIONAL).
+     *
+     *  returns if generation was successful
+     * */
+    bool nested(const uint8_t shape, const uint32_t n, const uint32_t cutoff,
+                const bool wait, const uint32_t t = DEFAULT_EXECUTION_SIZE);
+
+    /*
+     * Generates a directed acyclic graph straight into a .sdat file, in
+     * bounded memory, i.e. without building a task graph
+     *  filename is the name of the file (without extension);
+     *  n, m, d, t and r are the same as in generate.
+     *
+     *  returns if generation was successful
+     * */
+    bool stream(const char* filename, const uint32_t n, const uint32_t m,
+                const uint32_t d, const uint32_t t, const float r);
+
+    /*
+     * Set the distribution task durations are drawn from on the following
+     * generations (uniform by default)
+     *  dm    is the duration model
+     *
+     *  returns if the model is valid (else the previous one is kept)
+     * */
+    bool duration(const dmodel& dm);
+
     /**
      * Dispatch a graph to the runtime
      *  rt      is the runtime that will be used for dispatching
@@ -286,6 +747,91 @@ public:
      * */
     bool run(const uint8_t rt);
 
+    /**
+     * Dispatch a streamed graph (.sdat) to the runtime, reading it while
+     * dispatching and keeping a bounded window of tasks in memory
+     *  filename  is the name of the file (without extension)
+     *  rt        is the runtime that will be used for dispatching
+     *  window    is the max. no. of in-flight tasks
+     *
+     *  returns if execution was successful
+     * */
+    bool run(const char* filename, const uint8_t rt,
+             const uint32_t window = DEFAULT_WINDOW);
+
+    /**
+     * Dispatch the graphs of several labs at once, on a single parallel
+     * region, e.g. the task streams of the tenants of a service. Every graph
+     * is run following the configuration of its lab, and reported on its
+     * own, followed by how evenly graphs progressed. Threads and counters
+     * follow the configuration of the first lab.
+     *  labs    are the labs whose graphs are run (each one at most once)
+     *  rt      is the runtime that will be used for dispatching
+     *  mix     is how submissions of different graphs are mixed (see Mix)
+     *
+     *  returns if every graph executed correctly
+     * */
+    static bool run(const std::vector<TaskLab*>& labs, const uint8_t rt,
+                    const uint8_t mix);
+
+    /**
+     * Build the dispatch plan of the current graph, i.e. everything run
+     * needs besides the runtime itself. It is kept across runs until the
+     * graph changes, and built by run if needed.
+     *
+     *  returns if there is a plan ready to be dispatched
+     * */
+    bool prepare();
+
+    /**
+     * Run the current graph at increasing offered loads (open loop), in
+     * order to find where latency takes off before saturation
+     *  rt      is the runtime that will be used for dispatching
+     *  max_r   is the highest offered load (tasks/s)
+     *  steps   is the no. of loads, evenly spread up to max_r
+     *
+     *  returns if every run was successful
+     * */
+    bool load_curve(const uint8_t rt, const float max_r, const uint32_t steps);
+
+    /**
+     * Simulate the current graph on a hardware runtime, i.e. a task queue and
+     * a set-associative dependency table of fixed capacity fed by the
+     * dependency descriptors of each task, in order to size them. Submission
+     * stalls while the queue is full or the set of an address has no free
+     * entry; tasks over the dependency limit wait for the table to drain.
+     *  c       is the table to be modelled
+     *
+     *  returns if there was a graph to simulate
+     * */
+    bool simulate(const tcfg& c);
+
+    /**
+     * Measure the cost of the runtime primitives (ns): creating an empty
+     * task, creating a task with k dependencies (k = 1 to 64), releasing the
+     * successor on a chain, waking up N children (fan-out) or a join of N
+     * tasks (fan-in), and a taskwait round trip
+     *  rt        is the runtime to be measured
+     *  reps      is the no. of repetitions of each benchmark
+     *  filename  is where results are also written, as CSV (OPTIONAL)
+     *
+     *  returns if the runtime could be measured
+     * */
+    bool bench(const uint8_t rt, const uint32_t reps = BENCH_REPS,
+               const char* filename = NULL);
+
+    /**
+     * Set how the following runs dispatch graphs
+     *  c       is the run configuration
+     * */
+    void configure(const rcfg& c);
+
+    /**
+     * Get how runs dispatch graphs
+     *  returns the current run configuration
+     * */
+    const rcfg& config();
+
     /* ***************
      * Helper functions regarding simulation
      * *************** */
@@ -295,16 +841,22 @@ public:
      *  nruns   is the number of graphs to be generated
      *  max_t   is the max. no. of tasks that a graph may obtain
      *  rt      is the runtime that will be used for dispatching
+     *  jobs    is how many graphs are run at once, each by a thread (and
+     *          on a lab with the same configuration and durations) of its own
      */
-    void burnin(const uint32_t nruns, const uint32_t max_t, const uint8_t rt);
+    void burnin(const uint32_t nruns, const uint32_t max_t, const uint8_t rt,
+                const uint32_t jobs = 1);
 
     /*
      * Restores multiple task graphs from .dag files in a given folder and
      * dispatch them to runtime of choice.
      *  path  is the (full) path to the directory
      *  n     is how many times should we run each task graph
+     *  jobs  is how many graphs are run at once, each by a thread (and on a
+     *        lab) of its own
      */
-    void burnin(const char* path, uint16_t n, const uint8_t rt); 
+    void burnin(const char* path, uint16_t n, const uint8_t rt,
+                const uint32_t jobs = 1);
 
     /* ***************
      * Trace functions
@@ -347,6 +899,25 @@ public:
      */
     bool restore(const char* filename);
 
+    /**
+     * Save the statistics of a graph as a .prof file, which can be shared
+     * without revealing the graph itself
+     *  filename: name of the file
+     *  return:   true if it succeeds, else false
+     */
+    bool profile(const char* filename);
+
+    /**
+     * Generate a graph matching the statistics of a .prof file
+     *  filename:  name of the profile file
+     *  n:         number of tasks to be generated
+     *  keep_span: keep the no. of levels and widen them (else keep the
+     *             width of levels, i.e. the parallelism, and deepen the graph)
+     *  return:    true if it succeeds, else false
+     */
+    bool synthesize(const char* filename, const uint32_t n,
+                    const bool keep_span);
+
     /**
      * Save a graph as a .dot, .tsk or .info file
      *  filename: name of the file
@@ -376,17 +947,25 @@ public:
 private:
     TaskGraph*              tg;
 
+    /* Duration model of generated graphs */
+    dmodel                  dm;
+
     /* Watchable trace events */
     bool                    t_e[EVENT_S] {0};
 
-    /* Structures useful when dealing with despatching and
-     * errors */
-    static TaskGraph*       tg_t;
-    static bool             r_error;
-
     /* ***************
      * Dispatcher handlers
      * *************** */
+    /**
+     * Payload of a variable read or written by a task
+     */
+    typedef struct buffer_access {
+    public:
+        uint64_t* buf;      // words of the payload
+        uint32_t  n;        // no. of words
+        uint64_t  ver;      // version expected (reads) or written (writes)
+    } bacc_t;
+
     /**
      * Task parameter data structure regarding the despatching
      */
@@ -398,8 +977,214 @@ private:
         uint32_t pred_s;    // size of predecessors dep.
         uint32_t succ_s;    // size of successors dep.
         float    exec;      // default load time of task
+        uint8_t  kern;      // kernel run by the task (see Kernel)
+        bacc_t*  rd;        // payloads read (IN/INOUT)
+        bacc_t*  wr;        // payloads written (OUT/INOUT)
+        uint32_t rd_s;      // size of rd
+        uint32_t wr_s;      // size of wr
+        uint32_t parent;    // task spawning it (NONE: created by dispatcher)
+        uint32_t* kids;     // tasks it spawns once its work is done
+        uint32_t kids_s;    // size of kids
+        bool     wait;      // whether it waits for them
     } tparam_t;
 
+    /**
+     * Dispatch plan of a graph: parameters, validation pointers and
+     * dependency descriptors of every task, built once by prepare
+     */
+    typedef struct dispatch_plan {
+    public:
+        bool*            dep_chk;   // dependency validation (task graph)
+        char*            varmap;    // memory holding the variables
+        uint64_t         varmap_s;  // size of varmap
+        std::vector<kmp_intptr> vaddr; // address of each variable
+        std::vector<uint32_t>   vlen;  // length of each variable
+        tparam_t*        params;    // parameters of each task
+        bool**           chk_pool;  // validation pointers of every task
+        kmp_depend_info* dep_pool;  // dependency descriptors of every task
+        bacc_t*          acc_pool;  // payload accesses of every task
+        kmp_depend_info** dep_list; // descriptors of each task (on dep_pool)
+        uint32_t*        dep_n;     // no. of descriptors of each task
+        uint32_t         ntasks;    // no. of tasks of the planned graph
+        uint64_t         nchk;      // size of dep_chk (cache line padded)
+        uint64_t*        t_arr;     // when each task was due (ns, open loop)
+        uint64_t*        t_sub;     // when each task was submitted (ns, last run)
+        uint64_t*        t_beg;     // when each task started (ns, last run)
+        uint64_t*        t_end;     // when each task finished (ns, last run)
+        uint32_t*        t_thr;     // thread that ran each task (last run)
+        std::atomic<uint64_t>* t_ctr; // events counted by each task (NCTR
+                                    // per task, over the replays of the last
+                                    // run)
+        uint64_t         t_run;     // when the last run started (ns)
+
+        /* Replays of the last run */
+        std::vector<uint64_t>  r_sub;  // when each replay started (ns)
+        std::vector<uint64_t>  r_end;  // when each replay finished (ns)
+        std::atomic<uint32_t>* r_left; // no. of unfinished tasks of each replay
+
+        /* Whether a run is using the plan, so that others build their own */
+        bool             busy;
+
+        /* Nested graphs */
+        std::vector<uint32_t> kid;     // tasks spawned by every task
+        bool             nested;    // whether any task is spawned by another
+        bool             joined;    // whether every spawning task waits
+
+        /* Multi-producer dispatch */
+        std::vector<uint32_t> order;   // tasks sorted by topological level
+        std::vector<uint32_t> lvl;     // first task (on order) of each level
+        std::vector<uint32_t> pt;      // predecessor tasks of every task
+        std::vector<uint32_t> pt_off;  // first predecessor (on pt) of each task
+
+        dispatch_plan(TaskGraph* g, const rcfg& c);
+
+        /**
+         * Place variables following a layout
+         *  nvar:   no. of variables
+         *  c:      run configuration holding the layout
+         */
+        void lay_out(const uint32_t nvar, const rcfg& c);
+
+        /**
+         * Zero every payload written by a task, so that reads before any
+         * write find the version they expect (0) again
+         */
+        void reset_payloads();
+        ~dispatch_plan();
+    } plan_t;
+
+    /**
+     * State shared by the producers of a multi-producer dispatch
+     */
+    typedef struct producer_state {
+    public:
+        std::atomic<uint64_t>  next;     // next chunk to be claimed
+        std::atomic<uint32_t>* lvl_sub;  // no. of submitted tasks per level
+        std::atomic<bool>*     sub;      // whether a task was submitted
+        std::vector<uint32_t>  cbeg;     // first task (on order) of each chunk
+        std::vector<uint32_t>  clvl;     // level of each chunk
+        std::vector<uint32_t>  ids;      // id of each producer
+        std::vector<uint64_t>  count;    // no. of tasks created per producer
+        std::vector<double>    begin;    // when each producer started (s)
+        std::vector<double>    end;      // when each producer finished (s)
+    } pstate_t;
+
+    /**
+     * Where a thread was pinned and where it ran right after
+     */
+    typedef struct thread_place {
+    public:
+        int cpu;        // CPU the thread was pinned on (NONE if free)
+        int ran;        // CPU the thread was on right after
+    } tplace_t;
+
+    /**
+     * Placement of the threads of a parallel region (see placement.cpp)
+     */
+    typedef struct run_place {
+    public:
+        uint64_t                    id = 0; // region, told apart by threads
+        std::vector<int>            cpu;    // CPU of each thread slot
+        std::mutex                  lock;   // guards thr
+        std::map<int32_t, tplace_t> thr;    // threads of the region
+    } rplace_t;
+
+    /**
+     * Streamed graph being dispatched (see stream.cpp)
+     */
+    typedef struct stream_state {
+    public:
+        std::ifstream*     in;      // file it is read from
+        shead              h;       // its header
+        uint32_t           w;       // max. no. of in-flight tasks
+        std::atomic<bool>* free;    // whether a window slot is free
+    } sstate_t;
+
+    /**
+     * Run of a graph, i.e. everything its tasks need besides their own
+     * parameters. Several graphs may run at once, each one on its own state,
+     * as may several runs (of different labs, or of the same one).
+     */
+    typedef struct tenant_state {
+    public:
+        TaskGraph*            tg;       // graph being run
+        plan_t*               pl;       // its dispatch plan (NULL if streamed)
+        rcfg                  cfg;      // how it is dispatched
+        pstate_t*             ps;       // its producers (LEVEL/RANGE)
+        sstate_t*             ss;       // its stream (if streamed)
+        rplace_t*             pc;       // placement of its threads
+        bool                  shared;   // whether other graphs run alongside
+        std::atomic<bool>     error;    // whether it did not execute correctly
+        std::atomic<uint64_t> left;     // no. of unfinished tasks (shared)
+        uint64_t              t_done;   // when its last task finished (ns,
+                                        // shared)
+
+        /* In-flight window, i.e. tasks (and their dependencies) submitted
+         * but not finished yet, and how long producers stalled on it (ns) */
+        alignas(CACHE_LINE) std::atomic<uint32_t> fl_tasks;
+        alignas(CACHE_LINE) std::atomic<uint64_t> fl_deps;
+        alignas(CACHE_LINE) std::atomic<uint64_t> fl_stall;
+        std::atomic<uint64_t>                     fl_nstall;
+
+        /**
+         * Start the run of a graph, resetting what its plan keeps of the
+         * previous one
+         *  g:      graph to be run
+         *  p:      its plan (NULL if streamed)
+         *  c:      how it is dispatched
+         */
+        tenant_state(TaskGraph* g, plan_t* p, const rcfg& c);
+    } tenant_t;
+
+    /**
+     * Private data of a dispatched task
+     */
+    typedef struct task_private {
+    public:
+        tenant_t* tn;       // run of the graph of the task
+        uint32_t  it;       // replay of the task
+    } tpriv_t;
+
+    /**
+     * Parallel region of a run, handed to its microtask as its argument
+     */
+    typedef struct region_state {
+    public:
+        std::vector<tenant_t*> tn;      // graphs run on the region
+        uint8_t                mix;     // how their submissions mix (see Mix)
+        rplace_t               pc;      // placement of its threads
+    } region_t;
+
+    /**
+     * Outcome of an open-loop run
+     */
+    typedef struct load_stat {
+    public:
+        double   offered;   // offered load (tasks/s)
+        double   achieved;  // achieved throughput (tasks/s)
+        uint64_t p50;       // end-to-end latency percentiles (ns)
+        uint64_t p99;
+        uint64_t p999;
+    } lstat_t;
+
+    /* Outcome of the last open-loop run */
+    lstat_t                 ol;
+
+    /* Run configuration */
+    rcfg                    cfg;
+
+    /* Dispatch plan of the current graph, if prepared */
+    plan_t*                 pl;
+
+    /* Guards the plan (and the outcome of runs) against concurrent runs */
+    std::mutex              r_lock;
+
+    /**
+     * Throw away the dispatch plan, since the graph changed (a plan in use
+     * is only detached, and deleted by the run once released)
+     */
+    void invalidate();
+
     /**
      * Initialize functions that will in order to dispatch functions
      *  rt:         runtime to be establish communication
@@ -408,21 +1193,261 @@ private:
      */
     bool init_run(const uint8_t rt);
 
+    /**
+     * Take the dispatch plan of the current graph for a run, or build one
+     * for the run alone if another run is using it
+     *  c:      run configuration
+     *
+     *  return: plan of the run (NULL if there isn't any graph)
+     */
+    plan_t* claim(const rcfg& c);
+
+    /**
+     * Give back the plan of a run, deleting it if it is not the plan of the
+     * lab (anymore)
+     *  p:      plan taken by claim
+     */
+    void release(plan_t* p);
+
+    /**
+     * Threads of the team fork_call starts: as told by the runtime, else as
+     * asked through OMP_NUM_THREADS, else one per core
+     */
+    static uint32_t team_size();
+
+    /**
+     * Fall back on a dispatch a graph (and the runtime) supports
+     *  c:      configuration of the run about to start
+     *  p:      plan of the graph
+     *  rt:     runtime the run is dispatched to
+     */
+    static void settle(rcfg& c, const plan_t* p, const uint8_t rt);
+
+    /**
+     * Report the run of the current graph: in-flight window, replays,
+     * validation, latency, open-loop throughput and lost parallelism, as
+     * configured
+     *  tn:     state of the run
+     *
+     *  return: if the graph executed correctly
+     */
+    bool report(tenant_t& tn);
+
+    /**
+     * Check that every task ran after the earlier tasks it conflicts with on
+     * any variable, i.e. readers after the last writer (RAW) and writers after
+     * both the last writer (WAW) and the readers since then (WAR), where
+     * earlier means lower ID. Relies on the timeline of the run.
+     *  tn:         the run
+     *
+     *  return:     if no ordering constraint was violated
+     */
+    static bool check_order(const tenant_t& tn);
+
+    /**
+     * Report where a run lost parallelism, from its timeline: time
+     * during which tasks were ready (every predecessor done) while workers
+     * were idle, and tasks starting long after being ready, by no. of
+     * predecessors and worst first.
+     *  tn:     the run
+     */
+    static void lost_parallelism(const tenant_t& tn);
+
+    /**
+     * Report the scheduling latency of a run, i.e. from when each task
+     * became ready (its last predecessor finished, or it was submitted if it
+     * has none) until it started, overall, by no. of predecessors and by
+     * worker.
+     *  tn:     the run
+     */
+    static void latency(const tenant_t& tn);
+
+    /**
+     * Report the offered and achieved throughput of an (open-loop) run and
+     * the latency from each task being due until it finished
+     *  tn:     the run
+     *
+     *  return: the outcome
+     */
+    static lstat_t open_loop(const tenant_t& tn);
+
+    /**
+     * Report how long each replay of a run took, from when the previous
+     * one finished, and from when it started being submitted
+     *  tn:     the run
+     */
+    static void replays(const tenant_t& tn);
+
+    /**
+     * When each task of a run became ready
+     *  tn:     the run
+     *  ready:  ready time of each task (ns), by task ID
+     */
+    static void ready_times(const tenant_t& tn, std::vector<uint64_t>& ready);
+
+    /**
+     * Place the threads and variables of a run (see placement.cpp): resolve
+     * the CPU of each thread, pin the current one, and move or drop the
+     * pages of variables following the placement
+     *  pc:     placement of the threads of the region
+     *  tn:     run whose configuration and variables are followed
+     */
+    static void place_start(rplace_t* pc, const tenant_t* tn);
+
+    /**
+     * Pin the current thread on its CPU, once per region
+     *  pc:     placement of the threads of the region
+     *  gtid:   runtime id of the current thread
+     */
+    static void place(rplace_t* pc, kmp_int32 gtid);
+
+    /**
+     * Report where the threads of a region were pinned and ran, and on
+     * which nodes the pages of the variables of a run are
+     *  pc:     placement of the threads of the region
+     *  tn:     run whose variables are located
+     */
+    static void place_report(rplace_t* pc, const tenant_t& tn);
+
+    /**
+     * Start counting hardware events of a run (see counters.cpp), every
+     * thread on its own group of counters, the current one from now on.
+     * Threads count for a single run at a time, until it is reported.
+     *  return: if any event can be counted on the current thread
+     */
+    static bool ctr_start();
+
+    /**
+     * Open the counters of the workers of the team at region entry, through
+     * a task taken by each of them (threads outside the region are not
+     * counted)
+     *  gtid:   runtime id of the dispatching thread
+     */
+    static void ctr_team(kmp_int32 gtid);
+
+    /**
+     * Read the events counted so far by the current thread, opening its
+     * counters if it joined after region entry
+     *  gtid:   runtime id of the current thread
+     *  v:      NCTR counts (0 if not counted)
+     */
+    static void ctr_read(kmp_int32 gtid, uint64_t* v);
+
+    /**
+     * Stop counting and report the events of the last run: on the whole,
+     * within tasks, the difference (i.e. the runtime) and per thread
+     *  tn:     graphs of the run
+     */
+    static void ctr_report(const std::vector<tenant_t*>& tn);
+
+    /**
+     * Whether runs record the timeline of tasks
+     *  c:      run configuration
+     *  return: if tasks are stamped when submitted, started and finished
+     */
+    static bool timed(const rcfg& c);
+
     /**
      * Main dispatcher according to mtsp runtime signature, manage dependencies
      * between tasks, set dependency checker and dispatch them.
+     *  param:  region of the run (region_t)
      */
     static void microtask(int gid, int tid, void* param);
 
+    /**
+     * Create the tasks of a graph, serially (replays and open loop included)
+     * or through producers, as configured
+     *  tn:     run of the graph
+     *  gtid:   runtime id of the current thread
+     */
+    static void dispatch(tenant_t* tn, kmp_int32 gtid);
+
+    /**
+     * Create the tasks of every graph of a region, taking turns
+     *  rg:     the region
+     *  gtid:   runtime id of the current thread
+     */
+    static void interleave(region_t* rg, kmp_int32 gtid);
+
+    /**
+     * Create a task of a graph
+     *  tn:         run of the graph
+     *  gtid:       runtime id of the current thread
+     *  cur_task:   task to be created
+     *  it:         replay of the task
+     */
+    static void submit(tenant_t* tn, kmp_int32 gtid, uint32_t cur_task,
+                       uint32_t it);
+
+    /**
+     * Function called by the producer task of a graph, which dispatches it
+     * */
+    static void tenant_f(kmp_int32 gtid, void* param);
+
     /**
      * Default function called by each task when executed
      * */
     static void ptask_f(kmp_int32 gtid, void* param);
 
+    /**
+     * Wait until a task fits in the in-flight window, and take its place
+     *  tn:         run of the graph of the task
+     *  cur_task:   task to be submitted
+     */
+    static void admit(tenant_t* tn, uint32_t cur_task);
+
+    /**
+     * Whether runs bound the no. of in-flight tasks or dependencies
+     *  c:      run configuration
+     *  return: if tasks must be admitted before submitted
+     */
+    static bool throttled(const rcfg& c);
+
+    /**
+     * Create tasks as one of the producers of a multi-producer dispatch,
+     * claiming chunks of the graph until none is left
+     *  tn:     run of the graph
+     *  gtid:   runtime id of the current thread
+     *  id:     producer id
+     */
+    static void produce(tenant_t* tn, kmp_int32 gtid, uint32_t id);
+
+    /**
+     * Function called by each producer task when executed
+     * */
+    static void producer_f(kmp_int32 gtid, void* param);
+
+    /**
+     * Dispatcher of a streamed graph, reading and dispatching tasks within
+     * a window of in-flight tasks
+     *  param:  region of the run (region_t)
+     */
+    static void stream_microtask(int gid, int tid, void* param);
+
+    /**
+     * Function called by each streamed task when executed, which frees its
+     * slot on the window
+     * */
+    static void stask_f(kmp_int32 gtid, void* param);
+
+    /**
+     * Dispatcher of the runtime microbenchmarks, creating small graphs
+     * straight through the runtime symbols
+     *  param:  suite being measured (see bench.cpp)
+     */
+    static void bench_microtask(int gid, int tid, void* param);
+
+    /**
+     * Function called by each benchmark task when executed, which stamps
+     * when it ran once its gate (if any) opens
+     * */
+    static void btask_f(kmp_int32 gtid, void* param);
+
     /**
      * Function to be executed by each task
+     *  tn:     run of the graph of the task
      * */
-    static void f(tparam_t param);
+    static void f(tenant_t* tn, tparam_t param);
 
     /* ***************
      * Helpers
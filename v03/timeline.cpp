@@ -0,0 +1,355 @@
+/**
+ * Timeline.cpp
+ *   Analysis of the timeline of the last run, i.e. when each task started
+ *   and finished, against the graph it ran
+ *
+ * */
+
+#include "tasklab.h"
+
+#include <cstdio>
+#include <set>
+
+/* ************************
+ * Latency histogram
+ * ************************ */
+/**
+ * Log-linear histogram of latencies (ns): values are binned linearly within
+ * every power of two, so that any of them is kept within 1/2^HIST_SUB
+ */
+class Hist {
+public:
+    void add(const uint64_t v) {
+        uint32_t i = index(v);
+
+        if (i >= bins.size()) {
+            bins.resize(i + 1, 0);
+        }
+
+        ++bins[i];
+        ++total;
+        top = std::max(top, v);
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    uint64_t max() const {
+        return top;
+    }
+
+    /* Value below which a fraction q of the latencies lie */
+    uint64_t quantile(const double q) const {
+        uint64_t rank = std::ceil(q * total), cum = 0;
+
+        for (size_t i = 0; i < bins.size(); i++) {
+            cum += bins[i];
+
+            if (cum >= rank && cum > 0) {
+                return std::min(upper(i), top);
+            }
+        }
+
+        return top;
+    }
+
+private:
+    std::vector<uint64_t> bins;
+    uint64_t              total = 0;
+    uint64_t              top   = 0;
+
+    static uint32_t index(const uint64_t v) {
+        if (v < (1u << HIST_SUB)) {
+            return v;
+        }
+
+        uint32_t shift = 63 - __builtin_clzll(v) - HIST_SUB;
+
+        return ((shift + 1) << HIST_SUB) |
+               ((v >> shift) & ((1u << HIST_SUB) - 1));
+    }
+
+    // Highest value of a bin
+    static uint64_t upper(const uint32_t i) {
+        if (i < (1u << HIST_SUB)) {
+            return i;
+        }
+
+        uint32_t shift = (i >> HIST_SUB) - 1;
+        uint64_t lo    = ((uint64_t)(i & ((1u << HIST_SUB) - 1)) |
+                          (1u << HIST_SUB)) << shift;
+
+        return lo + ((uint64_t)1 << shift) - 1;
+    }
+};
+
+/* Print a row of latency percentiles (us) */
+static void hrow(const char* label, const Hist& h) {
+    printf("\t\t%-12s %10llu %10.2f %10.2f %10.2f %10.2f\n", label,
+           (unsigned long long)h.count(), h.quantile(0.5) / 1e3,
+           h.quantile(0.99) / 1e3, h.quantile(0.999) / 1e3, h.max() / 1e3);
+}
+
+void TaskLab::ready_times(const tenant_t& tn, std::vector<uint64_t>& ready) {
+    const plan_t* pl = tn.pl;
+
+    ready.assign(pl->ntasks, 0);
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        // Tasks without predecessors are ready once submitted
+        ready[t] = pl->pt_off[t] == pl->pt_off[t + 1] ? pl->t_sub[t] : 0;
+
+        for (uint32_t j = pl->pt_off[t]; j < pl->pt_off[t + 1]; j++) {
+            ready[t] = std::max(ready[t], pl->t_end[pl->pt[j]]);
+        }
+
+        // Nested tasks are not there until their parent spawns them
+        if (pl->params[t].parent != (uint32_t)NONE) {
+            ready[t] = std::max(ready[t], pl->t_sub[t]);
+        }
+
+        // Clocks of different threads may be slightly apart
+        ready[t] = std::min(ready[t], pl->t_beg[t]);
+    }
+}
+
+void TaskLab::latency(const tenant_t& tn) {
+    const plan_t*              pl = tn.pl;
+    std::vector<uint64_t>      ready;
+    Hist                       all;
+    std::map<uint32_t, Hist>   by_pred, by_thr;
+
+    ready_times(tn, ready);
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        uint64_t l = pl->t_beg[t] - ready[t];
+
+        all.add(l);
+        by_pred[pl->pt_off[t + 1] - pl->pt_off[t]].add(l);
+        by_thr[pl->t_thr[t]].add(l);
+    }
+
+    char label[32];
+
+    printf("--- Scheduling latency (us)\n");
+    printf("\t\t%-12s %10s %10s %10s %10s %10s\n", "", "tasks", "p50", "p99",
+           "p999", "max");
+
+    hrow("all", all);
+
+    std::map<uint32_t, Hist>::iterator it;
+    for (it = by_pred.begin(); it != by_pred.end(); ++it) {
+        sprintf(label, "%u preds", it->first);
+        hrow(label, it->second);
+    }
+
+    for (it = by_thr.begin(); it != by_thr.end(); ++it) {
+        sprintf(label, "worker %u", it->first);
+        hrow(label, it->second);
+    }
+}
+
+/* ************************
+ * Open-loop arrival
+ * ************************ */
+TaskLab::lstat_t TaskLab::open_loop(const tenant_t& tn) {
+    const plan_t* pl    = tn.pl;
+    const rcfg&   cfg   = tn.cfg;
+    Hist          e2e;
+    lstat_t       ol;
+    uint64_t      first = (uint64_t)-1, last = 0;
+
+    for (uint32_t t = 0; t < pl->ntasks; t++) {
+        e2e.add(pl->t_end[t] - std::min(pl->t_arr[t], pl->t_end[t]));
+
+        first = std::min(first, pl->t_arr[t]);
+        last  = std::max(last, pl->t_end[t]);
+    }
+
+    ol.offered  = cfg.rate;
+    ol.achieved = last > first ? pl->ntasks * 1e9 / (last - first) : 0;
+    ol.p50      = e2e.quantile(0.5);
+    ol.p99      = e2e.quantile(0.99);
+    ol.p999     = e2e.quantile(0.999);
+
+    const char* kind = cfg.arrival == Arrival::CONSTANT ? "constant" :
+                       cfg.arrival == Arrival::POISSON  ? "poisson" : "bursty";
+
+    printf("--- Open-loop arrival (%s)\n", kind);
+    printf("\tOffered load:        %.0f tasks/s\n", ol.offered);
+    printf("\tAchieved throughput: %.0f tasks/s\n", ol.achieved);
+    printf("\tEnd-to-end latency:  p50 %.2f us, p99 %.2f us, p999 %.2f us, \
+max %.2f us\n", ol.p50 / 1e3, ol.p99 / 1e3, ol.p999 / 1e3, e2e.max() / 1e3);
+
+    return ol;
+}
+
+/* ************************
+ * Replays
+ * ************************ */
+void TaskLab::replays(const tenant_t& tn) {
+    const plan_t* pl  = tn.pl;
+    const rcfg&   cfg = tn.cfg;
+    uint32_t      n   = pl->r_end.size();
+    double        sum = 0, lo = 0, hi = 0;
+
+    printf("--- Replays (%u, %s)\n", n, cfg.overlap ? "overlapped" :
+           "one at a time");
+    printf("\t\t%10s %14s %14s\n", "replay", "time (ms)", "latency (ms)");
+
+    for (uint32_t i = 0; i < n; i++) {
+        // Time between consecutive replays finishing, the first one from
+        // the start of the run (overlapped replays may finish out of order)
+        uint64_t prev = i > 0 ? pl->r_end[i - 1] : pl->r_sub[0];
+        double   t    = ((double)pl->r_end[i] - prev) / 1e6;
+        double   l    = ((double)pl->r_end[i] - pl->r_sub[i]) / 1e6;
+
+        if (i < MAX_LATE || i + 1 == n) {
+            printf("\t\t%10u %14.3f %14.3f\n", i, t, l);
+        } else if (i == MAX_LATE) {
+            printf("\t\t%10s\n", "...");
+        }
+
+        if (i > 0) {
+            lo   = i == 1 ? t : std::min(lo, t);
+            hi   = std::max(hi, t);
+            sum += t;
+        }
+    }
+
+    printf("\tFirst replay:        %.3f ms\n", (pl->r_end[0] - pl->r_sub[0]) / 1e6);
+    printf("\tFollowing replays:   avg. %.3f ms, min. %.3f ms, max. %.3f ms\n",
+           n > 1 ? sum / (n - 1) : 0, lo, hi);
+}
+
+/* ************************
+ * Lost parallelism
+ * ************************ */
+void TaskLab::lost_parallelism(const tenant_t& tn) {
+    const plan_t* pl  = tn.pl;
+    const rcfg&   cfg = tn.cfg;
+    uint32_t      n   = pl->ntasks;
+
+    if (n == 0) {
+        return;
+    }
+
+    /* -- Ready time of every task, i.e. when its last predecessor finished */
+    std::vector<uint64_t> ready;
+    std::vector<uint32_t> children(n, 0);
+    std::set<uint32_t>    workers;
+    uint64_t              last = pl->t_run;
+
+    ready_times(tn, ready);
+
+    for (uint32_t t = 0; t < n; t++) {
+        for (uint32_t j = pl->pt_off[t]; j < pl->pt_off[t + 1]; j++) {
+            ++children[pl->pt[j]];
+        }
+
+        last = std::max(last, pl->t_end[t]);
+
+        workers.insert(pl->t_thr[t]);
+    }
+
+    /* -- Sweep over the timeline, keeping the no. of ready and running
+     * tasks between events */
+    typedef struct { uint64_t time; int ready; int running; } event;
+
+    std::vector<event> ev;
+    ev.reserve(3 * (size_t)n);
+
+    for (uint32_t t = 0; t < n; t++) {
+        ev.push_back({ ready[t],       1, 0 });
+        ev.push_back({ pl->t_beg[t], -1, 1 });
+        ev.push_back({ pl->t_end[t],   0, -1 });
+    }
+
+    std::sort(ev.begin(), ev.end(), [](const event& a, const event& b) {
+        return a.time < b.time;
+    });
+
+    int64_t  w     = workers.size();
+    int64_t  nr    = 0, nx = 0;     // no. of ready and running tasks
+    uint64_t idle  = 0;             // time with ready tasks and idle workers
+    double   lost  = 0;             // worker time lost meanwhile
+
+    for (size_t i = 0; i < ev.size(); i++) {
+        nr += ev[i].ready;
+        nx += ev[i].running;
+
+        if (i + 1 == ev.size() || ev[i + 1].time == ev[i].time) {
+            continue;
+        }
+
+        uint64_t dt = ev[i + 1].time - ev[i].time;
+
+        if (nr > 0 && nx < w) {
+            idle += dt;
+            lost += (double)std::min(nr, w - nx) * dt;
+        }
+    }
+
+    /* -- Start lag of every task, by no. of predecessors */
+    typedef struct { uint64_t tasks; double lag; uint64_t late; } bucket;
+
+    std::map<uint32_t, bucket> by_pred;
+    std::vector<uint32_t>      order(n);
+    uint64_t                   thr  = (uint64_t)cfg.lag * 1000;
+    uint64_t                   late = 0;
+    double                     sum  = 0;
+
+    for (uint32_t t = 0; t < n; t++) {
+        uint64_t lag = pl->t_beg[t] - ready[t];
+        bucket&  b   = by_pred[pl->pt_off[t + 1] - pl->pt_off[t]];
+
+        ++b.tasks;
+        b.lag  += lag;
+        b.late += lag > thr;
+        late   += lag > thr;
+        sum    += lag;
+
+        order[t] = t;
+    }
+
+    uint32_t k = std::min(n, (uint32_t)MAX_LATE);
+
+    std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                      [&](uint32_t a, uint32_t b) {
+        return pl->t_beg[a] - ready[a] > pl->t_beg[b] - ready[b];
+    });
+
+    double span = last - pl->t_run;
+
+    printf("--- Lost parallelism\n");
+    printf("\tWorkers:                      %zu\n", workers.size());
+    printf("\tIdle while tasks were ready:  %.3f ms (%.1f%% of the run)\n",
+           idle / 1e6, span > 0 ? 100 * idle / span : 0);
+    printf("\tWorker time lost:             %.3f ms (%.1f%% of worker time)\n",
+           lost / 1e6, span > 0 ? 100 * lost / (span * w) : 0);
+    printf("\tAvg. start lag:               %.2f us\n", sum / n / 1e3);
+    printf("\tLate tasks (lag > %u us):     %llu (%.1f%%)\n", cfg.lag,
+           (unsigned long long)late, 100.0 * late / n);
+
+    printf("\tBy no. of predecessors:\n");
+    printf("\t\t%8s %10s %14s %10s\n", "preds", "tasks", "avg. lag (us)", "late");
+
+    std::map<uint32_t, bucket>::iterator it;
+    for (it = by_pred.begin(); it != by_pred.end(); ++it) {
+        printf("\t\t%8u %10llu %14.2f %10llu\n", it->first,
+               (unsigned long long)it->second.tasks,
+               it->second.lag / it->second.tasks / 1e3,
+               (unsigned long long)it->second.late);
+    }
+
+    printf("\tMost delayed tasks:\n");
+    printf("\t\t%8s %8s %8s %14s\n", "task", "preds", "children", "lag (us)");
+
+    for (uint32_t i = 0; i < k; i++) {
+        uint32_t t = order[i];
+
+        printf("\t\t%8u %8u %8u %14.2f\n", t, pl->pt_off[t + 1] - pl->pt_off[t],
+               children[t], (pl->t_beg[t] - ready[t]) / 1e3);
+    }
+}
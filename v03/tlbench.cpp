@@ -0,0 +1,242 @@
+/**
+ * tlbench.cpp
+ *   timed benchmarks of TaskLab itself, i.e. of everything done to a graph
+ *   before any task reaches the runtime
+ *
+ *   usage: "./tlbench [results file] [repetitions]", or simply "make bench"
+ *
+ *   "./tlbench -r [results file] [repetitions]" measures the runtime
+ *   primitives instead (see TaskLab::bench), with the runtime preloaded, or
+ *   simply "make micro RT_LIB=<runtime library>"
+ **/
+
+#include "tasklab.h"
+
+#include <iostream>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <boost/filesystem.hpp>
+
+/* Definitions */
+#define RESULTS_FILE "tlbench.csv"  // default results file
+#define MICRO_FILE   "rtbench.csv"  // default results file of the runtime
+#define REPS         3              // default repetitions of each benchmark
+
+#define ADD_DEPS     4              // dependencies per traced task
+#define ADD_POOL     1024           // addresses of random traced streams
+
+namespace fs = boost::filesystem;
+
+/* ************************
+ * Measurement
+ * ************************ */
+static FILE*       out;             // results file
+static uint32_t    reps;            // repetitions of each benchmark
+static std::string dir;             // where benchmarks write their files
+
+/* Nothing to set up before a repetition */
+static void none() {}
+
+/* Time f over every repetition, each one after an (untimed) setup, and
+ * record the best and mean times
+ *  name:  benchmark
+ *  param: parameters of the benchmark
+ *  n:     no. of tasks of the graph, to normalize times by */
+template<typename S, typename F>
+void measure(const char* name, const std::string& param, const uint32_t n,
+             S setup, F f) {
+    double best = 0, sum = 0;
+
+    // Whatever benchmarks print is not part of the results
+    int null = open("/dev/null", O_WRONLY), keep = dup(STDOUT_FILENO);
+
+    fflush(stdout);
+    dup2(null, STDOUT_FILENO);
+
+    for (uint32_t r = 0; r < reps; r++) {
+        setup();
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+        f();
+
+        std::chrono::duration<double, std::milli> el =
+            std::chrono::steady_clock::now() - t0;
+
+        best = r == 0 ? el.count() : std::min(best, el.count());
+        sum += el.count();
+    }
+
+    fflush(stdout);
+    dup2(keep, STDOUT_FILENO);
+    close(keep);
+    close(null);
+
+    printf("\t%-12s %-20s %8u %12.3f %12.3f %12.1f\n", name, param.c_str(), n,
+           best, sum / reps, n ? best * 1e6 / n : 0);
+    fprintf(out, "%s,%s,%u,%u,%.6f,%.6f,%.3f\n", name, param.c_str(), n, reps,
+            best, sum / reps, n ? best * 1e6 / n : 0);
+
+    fflush(out);
+}
+
+/* ************************
+ * Synthetic traces
+ * ************************ */
+/* Trace a graph of n tasks from an address stream, as add_task sees them:
+ * sequential tasks write a new address and read the last few, random ones
+ * access any address of a small pool in any mode */
+static void trace(TaskLab& tl, const uint32_t n, const bool random) {
+    std::mt19937 gen(n);
+    dep          deps[ADD_DEPS];
+    task         t;
+
+    t.WDPtr  = 0;
+    t.deparr = deps;
+
+    for (uint32_t i = 0; i < n; i++) {
+        t.tID   = i;
+        t.ndeps = 0;
+
+        if (random) {
+            for (uint32_t j = 0; j < ADD_DEPS; j++) {
+                deps[j].varptr = 8 * (gen() % ADD_POOL);
+                deps[j].mode   = Type::IN + gen() % Type::INOUT;
+            }
+
+            t.ndeps = ADD_DEPS;
+        } else {
+            deps[t.ndeps++] = { 8 * (uint64_t)i, Type::OUT };
+
+            for (uint32_t j = 1; j < ADD_DEPS && j <= i; j++) {
+                deps[t.ndeps++] = { 8 * (uint64_t)(i - j), Type::IN };
+            }
+        }
+
+        tl.eventOccurred(Evt::HTASK, &t);
+    }
+}
+
+/* ************************
+ * Main
+ * ************************ */
+int main (int argc, char* argv[]) {
+    /* -- Runtime primitives, on their own results file */
+    if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+        const char* results = argc > 2 ? argv[2] : MICRO_FILE;
+        TaskLab     tl;
+
+        reps = argc > 3 ? std::max(atoi(argv[3]), 1) : BENCH_REPS;
+
+        return tl.bench(RT::MTSP, reps, results) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    const char* results = argc > 1 ? argv[1] : RESULTS_FILE;
+
+    reps = argc > 2 ? std::max(atoi(argv[2]), 1) : REPS;
+    out  = fopen(results, "w");
+
+    if (out == NULL) {
+        fprintf(stderr, "[ERROR] Invalid filename. Couldn't write results.\n");
+
+        return EXIT_FAILURE;
+    }
+
+    dir = std::string(TMPDIR) + "tlbench_" + std::to_string(getpid()) + "/";
+
+    fs::create_directories(dir);
+
+    std::string file = dir + "graph";
+    uint32_t    ns[] = { 1000, 10000, 100000 };
+
+    fprintf(out, "benchmark,params,ntasks,reps,best_ms,mean_ms,best_ns_per_task\n");
+
+    printf("TaskLab benchmarks (%u repetitions, results on %s)\n", reps, results);
+    printf("\t%-12s %-20s %8s %12s %12s %12s\n", "benchmark", "params", "tasks",
+           "best (ms)", "mean (ms)", "ns/task");
+
+    /* -- Generation, at increasing sizes, dependencies and ranges */
+    uint32_t md[][2] = { { 2, 10 }, { 8, 10 }, { 8, 100 } };
+
+    for (uint32_t n : ns) {
+        for (uint32_t i = 0; i < 3; i++) {
+            TaskLab     tl;
+            std::string param = "m=" + std::to_string(md[i][0]) +
+                                " d=" + std::to_string(md[i][1]);
+
+            measure("create_tasks", param, n, none, [&]() {
+                tl.generate(n, md[i][0], md[i][1], DEFAULT_EXECUTION_SIZE,
+                            DEFAULT_EXECUTION_RANGE);
+            });
+        }
+    }
+
+    /* -- Tracing, from sequential and random address streams */
+    for (uint32_t n : ns) {
+        for (int random = 0; random < 2; random++) {
+            TaskLab* tl = NULL;
+
+            measure("add_task", random ? "random" : "sequential", n, [&]() {
+                delete tl;
+                tl = new TaskLab();
+            }, [&]() {
+                trace(*tl, n, random);
+            });
+
+            delete tl;
+        }
+    }
+
+    /* -- Serialization and plotting of generated graphs */
+    for (uint32_t n : ns) {
+        TaskLab tl, back;
+
+        tl.generate(n, 4, DEFAULT_DEP_RANGE, DEFAULT_EXECUTION_SIZE,
+                    DEFAULT_EXECUTION_RANGE);
+
+        measure("save", ".dat", n, none, [&]() {
+            tl.save(file.c_str());
+        });
+        measure("restore", ".dat", n, none, [&]() {
+            back.restore(file.c_str());
+        });
+        measure("profile", ".prof", n, none, [&]() {
+            tl.profile(file.c_str());
+        });
+        measure("synthesize", ".prof", n, none, [&]() {
+            back.synthesize(file.c_str(), n, false);
+        });
+        measure("stream", ".sdat", n, none, [&]() {
+            back.stream(file.c_str(), n, 4, DEFAULT_DEP_RANGE,
+                        DEFAULT_EXECUTION_SIZE, DEFAULT_EXECUTION_RANGE);
+        });
+        measure("plot", "dot", n, none, [&]() {
+            tl.plot(file.c_str(), Plot::DOT);
+        });
+        measure("plot", "info", n, none, [&]() {
+            tl.plot(file.c_str(), Plot::INFO);
+        });
+    }
+
+    /* -- Dispatch plan, i.e. what microtask needs before creating tasks */
+    for (uint32_t n : ns) {
+        for (uint32_t m : { 2u, 8u }) {
+            TaskLab tl;
+
+            measure("prepare", "m=" + std::to_string(m), n, [&]() {
+                tl.generate(n, m, DEFAULT_DEP_RANGE, DEFAULT_EXECUTION_SIZE,
+                            DEFAULT_EXECUTION_RANGE);
+            }, [&]() {
+                tl.prepare();
+            });
+        }
+    }
+
+    fclose(out);
+
+    fs::remove_all(dir);
+
+    return EXIT_SUCCESS;
+}